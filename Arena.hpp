@@ -0,0 +1,80 @@
+#pragma once
+#include "Cosmetics.hpp"
+#include <memory>
+#include <mutex>
+
+namespace warpsf {
+
+// scratch blocks shared by every filter instance in the process. a block goes back to the arena when its holder is
+// done and is handed to the next request it is large enough for, the smallest such one first, so filters of different
+// widths and types recycle one another's blocks, and after warm-up GetFrame allocates nothing and the footprint stays
+// at its peak. the arena lives as long as any filter holds it.
+class ScratchArena final {
+	struct Idle final {
+		self(block, static_cast<float*>(nullptr));
+		self(floats, 0_size);
+	};
+	std::mutex mutex;
+	std::vector<Idle> idle;
+	self(allocated, 0_size);
+	self(allocated_bytes, 0_size);
+	auto Recycle(float* block, std::size_t floats) {
+		auto lock = std::lock_guard{ mutex };
+		idle.push_back({ block, floats });
+	}
+	struct Recycler final {
+		self(arena, static_cast<ScratchArena*>(nullptr));
+		self(floats, 0_size);
+		auto operator()(float* block) const {
+			arena->Recycle(block, floats);
+		}
+	};
+public:
+	using Block = std::unique_ptr<float, Recycler>;
+	ScratchArena() = default;
+	ScratchArena(ScratchArena&&) = delete;
+	ScratchArena(const ScratchArena&) = delete;
+	auto operator=(ScratchArena&&)->decltype(*this) = delete;
+	auto operator=(const ScratchArena&)->decltype(*this) = delete;
+	~ScratchArena() {
+		for (auto& x : idle)
+			::operator delete(x.block, std::align_val_t{ 64 });
+	}
+	static auto Shared() {
+		static auto mutex = std::mutex{};
+		static auto shared = std::weak_ptr<ScratchArena>{};
+		auto lock = std::lock_guard{ mutex };
+		auto arena = shared.lock();
+		if (arena == nullptr)
+			shared = arena = std::make_shared<ScratchArena>();
+		return arena;
+	}
+	// a block of at least floats floats, aligned to 64 bytes.
+	auto Acquire(std::size_t floats) {
+		auto lock = std::lock_guard{ mutex };
+		auto best = idle.end();
+		for (auto x = idle.begin(); x != idle.end(); ++x)
+			if (x->floats >= floats && (best == idle.end() || x->floats < best->floats))
+				best = x;
+		auto taken = Idle{};
+		if (best == idle.end()) {
+			taken = { static_cast<float*>(::operator new(floats * sizeof(float), std::align_val_t{ 64 })), floats };
+			++allocated;
+			allocated_bytes += floats * sizeof(float);
+		}
+		else {
+			taken = *best;
+			idle.erase(best);
+		}
+		return Block{ taken.block, Recycler{ this, taken.floats } };
+	}
+	auto PeakBlocks() {
+		auto lock = std::lock_guard{ mutex };
+		return allocated;
+	}
+	auto PeakBytes() {
+		auto lock = std::lock_guard{ mutex };
+		return allocated_bytes;
+	}
+};
+}
\ No newline at end of file
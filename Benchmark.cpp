@@ -0,0 +1,447 @@
+// standalone throughput benchmark, built from the plugin sources without VapourSynth:
+//     g++ -std=c++17 -O2 -pthread Benchmark.cpp -o benchmark
+// "benchmark" sweeps every kernel set and the full GetFrame paths and prints one JSON array on stdout,
+// "benchmark --quick" only runs SD and 1080p with one and all threads.
+#include "Source.cpp"
+#include "MockAPI.hpp"
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#if defined(WARPSF_X86) && !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+auto read_cycles = []() {
+#ifdef WARPSF_X86
+	return static_cast<double>(__rdtsc());
+#else
+	return 0.;
+#endif
+};
+
+// L1 data cache read misses and last level cache misses of the calling thread, from the Linux perf events. either
+// reads as -1 where the kernel or the hypervisor does not expose the counter.
+class MissCounters final {
+	self(descriptors, std::array{ -1, -1 });
+public:
+	MissCounters() {
+#ifdef __linux__
+		auto open = [](auto type, auto config) {
+			auto attributes = perf_event_attr{};
+			attributes.size = sizeof(attributes);
+			attributes.type = type;
+			attributes.config = config;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+		};
+		descriptors = { open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16), open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES) };
+#endif
+	}
+	MissCounters(const MissCounters&) = delete;
+	auto operator=(const MissCounters&)->decltype(*this) = delete;
+	~MissCounters() {
+#ifdef __linux__
+		for (auto x : descriptors)
+			if (x >= 0)
+				close(x);
+#endif
+	}
+	auto Read() const {
+		auto counts = std::array{ -1., -1. };
+#ifdef __linux__
+		for (auto i : Range{ 2 })
+			if (auto value = std::uint64_t{}; descriptors[i] >= 0 && read(descriptors[i], &value, sizeof(value)) == sizeof(value))
+				counts[i] = static_cast<double>(value);
+#endif
+		return counts;
+	}
+	static auto& Instance() {
+		static auto counters = MissCounters{};
+		return counters;
+	}
+};
+
+// best of at least two timed runs after a warm-up, repeated until budget seconds have been spent: seconds, cycles and
+// the L1 and last level misses of that run, the misses -1 where they are not counted.
+auto measure = [](auto budget, auto body) {
+	auto best = std::array{ 1e300, 0., -1., -1. };
+	auto total = 0.;
+	auto& counters = MissCounters::Instance();
+	body();
+	for (auto runs = 0; runs < 2 || total < budget; ++runs) {
+		auto start = std::chrono::steady_clock::now();
+		auto misses = counters.Read();
+		auto cycles = read_cycles();
+		body();
+		cycles = read_cycles() - cycles;
+		auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		auto [l1_misses, llc_misses] = counters.Read();
+		total += seconds;
+		if (seconds < best[0])
+			best = { seconds, cycles, misses[0] < 0 ? -1. : l1_misses - misses[0], misses[1] < 0 ? -1. : llc_misses - misses[1] };
+	}
+	return best;
+};
+
+class Report final {
+	self(first, true);
+public:
+	Report() {
+		std::cout << "[";
+	}
+	~Report() {
+		std::cout << "\n]" << std::endl;
+	}
+	template<typename...Fields>
+	auto Add(std::array<double, 4> best, double pixels, Fields...fields) {
+		auto line = std::ostringstream{};
+		auto field = [&](auto& ycomb, auto key, auto value, auto...rest) {
+			line << "\"" << key << "\": ";
+			if constexpr (std::is_convertible_v<decltype(value), std::string>)
+				line << "\"" << std::string{ value } << "\", ";
+			else
+				line << value << ", ";
+			if constexpr (sizeof...(rest) != 0)
+				ycomb(ycomb, rest...);
+		};
+		field(field, fields...);
+		line << "\"mpix_per_s\": " << pixels / best[0] / 1e6 << ", ";
+		auto per_pixel = [&](auto key, auto count) {
+			if (count >= 0.)
+				line << "\"" << key << "\": " << count / pixels;
+			else
+				line << "\"" << key << "\": null";
+		};
+		per_pixel("cycles_per_pixel", best[1] > 0. ? best[1] : -1.);
+		line << ", ";
+		per_pixel("l1d_misses_per_pixel", best[2]);
+		line << ", ";
+		per_pixel("llc_misses_per_pixel", best[3]);
+		std::cout << (first ? "\n  {" : ",\n  {") << line.str() << "}" << std::flush;
+		first = false;
+	}
+};
+
+struct Buffer final {
+	self(stride, 0);
+	self(data, std::shared_ptr<std::uint8_t>{});
+	Buffer(int width, int height, std::mt19937& rng) {
+		stride = (width * static_cast<int>(sizeof(float)) + 63) / 64 * 64;
+		data = std::shared_ptr<std::uint8_t>{ vs_aligned_malloc<std::uint8_t>(static_cast<std::size_t>(stride) * height, 64), vs_aligned_free };
+		auto values = std::uniform_real_distribution<float>{ 0.f, 1.f };
+		for (auto y : Range{ height })
+			for (auto x : Range{ width })
+				reinterpret_cast<float*>(data.get() + static_cast<std::size_t>(y) * stride)[x] = values(rng);
+	}
+	auto get() const {
+		return data.get();
+	}
+	auto row(int y) const {
+		return reinterpret_cast<float*>(data.get() + static_cast<std::size_t>(y) * stride);
+	}
+};
+
+struct Resolution final {
+	self(name, "");
+	self(width, 0);
+	self(height, 0);
+	auto Unpack() const {
+		return std::tuple{ name, width, height };
+	}
+};
+
+struct KernelChoice final {
+	self(name, "");
+	self(isa, ISA::None);
+	self(single, true);
+};
+
+auto fill_random = [](auto frame, auto& rng) {
+	auto values = std::uniform_real_distribution<float>{ 0.f, 1.f };
+	auto words = std::uniform_int_distribution<int>{ 0, 65535 };
+	for (auto plane : Range{ frame->format->numPlanes })
+		for (auto y : Range{ frame->height[plane] })
+			for (auto x : Range{ frame->width[plane] })
+				if (auto row = frame->planes[plane].get() + static_cast<std::size_t>(y) * frame->stride[plane]; frame->format->sampleType == stFloat)
+					reinterpret_cast<float*>(row)[x] = values(rng);
+				else
+					reinterpret_cast<std::uint16_t*>(row)[x] = static_cast<std::uint16_t>(words(rng));
+};
+
+// random samples between black bars across the top and bottom 1/8 of each plane, as in 2.39:1 content in a 16:9 frame.
+auto fill_letterboxed = [](auto frame, auto& rng) {
+	fill_random(frame, rng);
+	for (auto plane : Range{ frame->format->numPlanes })
+		for (auto y : Range{ frame->height[plane] })
+			if (y < frame->height[plane] / 8 || y >= frame->height[plane] - frame->height[plane] / 8)
+				std::memset(frame->planes[plane].get() + static_cast<std::size_t>(y) * frame->stride[plane], 0, static_cast<std::size_t>(frame->width[plane]) * frame->format->bytesPerSample);
+};
+
+// a synthetic picture of soft rings, hard edged bars across the bottom quarter and a little grain, so the edge mask has
+// both smooth and sharp gradients.
+auto fill_scene = [](auto frame, auto& rng) {
+	auto grain = std::normal_distribution<double>{ 0., .02 };
+	for (auto plane : Range{ frame->format->numPlanes })
+		for (auto y : Range{ frame->height[plane] })
+			for (auto x : Range{ frame->width[plane] }) {
+				auto [u, v] = std::array{ (x + .5) / frame->width[plane], (y + .5) / frame->height[plane] };
+				auto radius = std::hypot(u - .5, (v - .5) * frame->height[plane] / frame->width[plane]);
+				auto bar = v > .75 && static_cast<int>(u * 16) % 2 == 1 ? .2 : 0.;
+				auto value = std::clamp(.5 + .25 * std::sin(40. * radius) + bar + grain(rng), 0., 1.);
+				reinterpret_cast<float*>(frame->planes[plane].get() + static_cast<std::size_t>(y) * frame->stride[plane])[x] = static_cast<float>(value);
+			}
+};
+
+// the mean of each block of 1 << shift by 1 << shift samples of a float frame.
+auto box_downscale = [](auto& source, auto frame, auto shift) {
+	for (auto plane : Range{ frame->format->numPlanes })
+		for (auto y : Range{ frame->height[plane] })
+			for (auto x : Range{ frame->width[plane] }) {
+				auto sum = 0.;
+				for (auto i : Range{ 1 << shift })
+					for (auto j : Range{ 1 << shift })
+						sum += reinterpret_cast<const float*>(source->planes[plane].get() + static_cast<std::size_t>((y << shift) + i) * source->stride[plane])[(x << shift) + j];
+				reinterpret_cast<float*>(frame->planes[plane].get() + static_cast<std::size_t>(y) * frame->stride[plane])[x] = static_cast<float>(sum / (1 << 2 * shift));
+			}
+};
+
+int main(int argc, char** argv) {
+	auto quick = argc > 1 && argv[1] == "--quick"s;
+	auto budget = quick ? .1 : .5;
+	auto resolutions = std::vector<Resolution>{ { "SD", 720, 480 }, { "HD", 1280, 720 }, { "FHD", 1920, 1080 }, { "UHD", 3840, 2160 }, { "8K", 7680, 4320 } };
+	if (quick)
+		resolutions = { resolutions[0], resolutions[2] };
+	auto thread_counts = std::vector<long long>{};
+	for (auto n = 1ll; n < ThreadPool::HardwareThreads(); n *= 2)
+		if (quick == false || n == 1)
+			thread_counts.push_back(n);
+	thread_counts.push_back(ThreadPool::HardwareThreads());
+	auto kernel_sets = std::vector<KernelChoice>{ { "reference", ISA::None, false }, { "scalar", ISA::None, true } };
+	for (auto choice : { KernelChoice{ "sse2", ISA::SSE2 }, KernelChoice{ "avx2", ISA::AVX2 }, KernelChoice{ "avx512", ISA::AVX512 } })
+		if (choice.isa <= SupportedISA())
+			kernel_sets.push_back(choice);
+	auto rng = std::mt19937{ 1 };
+	auto report = Report{};
+
+	for (auto& entry : resolutions) {
+		auto [resolution, width, height] = entry.Unpack();
+		auto src = Buffer{ width, height, rng };
+		auto mask = Buffer{ width, height, rng };
+		auto dst = Buffer{ width, height, rng };
+		auto doubled = width * height <= 3840 * 2160 ? std::make_unique<Buffer>(width * 2, height * 2, rng) : nullptr;
+		auto upsampled = width * height <= 1920 * 1080 ? std::make_unique<Buffer>(width * 4, height * 4, rng) : nullptr;
+		auto pixels = static_cast<double>(width) * height;
+		auto samples = PlaneSamples{};
+		for (auto& choice : kernel_sets) {
+			auto set = choice.name;
+			auto isa = choice.isa;
+			auto single = choice.single;
+			auto sobel = select_kernels(isa, 1ll, single);
+			report.Add(measure(budget, [&] {
+				sobel_plane(sobel, src.get(), dst.get(), src.stride, dst.stride, width, height, 0, height, .5, samples, samples, static_cast<float*>(nullptr));
+			}), pixels, "bench", "kernel", "kernel", "sobel", "set", set, "resolution", resolution, "width", width, "height", height);
+			for (auto blur_type : { 1ll, 0ll })
+				for (auto blur_level : blur_type == 1 ? std::array{ 1ll, 3ll } : std::array{ 1ll, 2ll }) {
+					auto kernels = select_kernels(isa, blur_type, single);
+					auto row_stride = scratch_stride(width);
+					auto buffer = std::vector<float>(blur_stream_rows(kernels, blur_level) * row_stride);
+					report.Add(measure(budget, [&] {
+						blur_stream(kernels, width, height, 0, height, blur_level, buffer.data(), row_stride,
+							[&](auto y, auto) { return static_cast<const float*>(src.row(y)); },
+							[&](auto y) { return dst.row(y); },
+							[](auto) {});
+					}), pixels, "bench", "kernel", "kernel", blur_type == 1 ? "blur_r2" : "blur_r6", "set", set, "resolution", resolution, "width", width, "height", height, "blur", blur_level);
+				}
+			for (auto SMAGL : { 0, 1, 2 }) {
+				auto source = std::array{ &src, doubled.get(), upsampled.get() }[SMAGL];
+				if (source == nullptr)
+					continue;
+				report.Add(measure(budget, [&] {
+					warp_plane(sobel, source->get(), mask.get(), dst.get(), source->stride, mask.stride, dst.stride, width, height, 0, height, 3ll, SMAGL, 0, 0, samples, samples, static_cast<float*>(nullptr), 0);
+				}), pixels, "bench", "kernel", "kernel", "warp", "set", set, "resolution", resolution, "width", width, "height", height, "smagl", SMAGL);
+			}
+			// the shared gradient path row by row, in the strips it picks for this CPU's L2, and for a 256 KiB L2.
+			for (auto SMAGL : { 1, 2 })
+				if (auto source = std::array{ &src, doubled.get(), upsampled.get() }[SMAGL]; source != nullptr && sobel.warp_gradient_row != nullptr)
+					for (auto cache_bytes : { std::numeric_limits<std::size_t>::max() / 1024, L2CacheBytes(), 256_size << 10 }) {
+						auto targets = std::array{ WarpTarget{ source->get(), dst.get(), source->stride, dst.stride, width, height, 3ll, 0, 0 } };
+						auto row_stride = scratch_stride(width);
+						auto scratch = std::vector<float>(warp_scratch_rows() * row_stride);
+						report.Add(measure(budget, [&] {
+							warp_targets(sobel, targets, mask.get(), mask.stride, width, height, 0, 0, height, SMAGL, 0, samples, samples, scratch.data(), row_stride, cache_bytes);
+						}), pixels, "bench", "kernel", "kernel", "warp_gradient", "set", set, "resolution", resolution, "width", width, "height", height, "smagl", SMAGL,
+							"strip", warp_strip_width(width, 4, SMAGL, cache_bytes));
+					}
+		}
+	}
+
+	auto& mock = MockCore::Instance();
+	auto format = mock.Format(cmYUV, stFloat, 32);
+	auto word_format = mock.Format(cmYUV, stInteger, 16);
+	for (auto& entry : resolutions) {
+		auto [resolution, width, height] = entry.Unpack();
+		auto clip = mock.Source(format, width, height, 1, [&](auto frame) { fill_random(frame, rng); });
+		auto word_clip = mock.Source(word_format, width, height, 1, [&](auto frame) { fill_random(frame, rng); });
+		auto mask = mock.Source(format, width, height, 1, [&](auto frame) { fill_random(frame, rng); });
+		auto doubled = width * height <= 3840 * 2160 ? mock.Source(format, width * 2, height * 2, 1, [&](auto frame) { fill_random(frame, rng); }) : nullptr;
+		auto upsampled = width * height <= 1920 * 1080 ? mock.Source(format, width * 4, height * 4, 1, [&](auto frame) { fill_random(frame, rng); }) : nullptr;
+		auto samples = 3. * width * height;
+		auto versions = std::array{ clip, mock.Source(format, width, height, 1, [&](auto frame) { fill_random(frame, rng); }), mock.Source(format, width, height, 1, [&](auto frame) { fill_random(frame, rng); }) };
+		auto field_args = VSMap{};
+		MockCore::Arg(field_args, "mask", mask);
+		auto displacement = MockCore::Clip(mock.Invoke("ADisplacement", field_args));
+		auto letterboxed = mock.Source(format, width, height, 1, [&](auto frame) { fill_letterboxed(frame, rng); });
+		auto edge_args = VSMap{};
+		MockCore::Arg(edge_args, "clip", letterboxed);
+		auto edge_frame = mock.GetFrame(MockCore::Clip(mock.Invoke("ASobel", edge_args)), 0);
+		auto letterboxed_edges = mock.Source(format, width, height, 1, [&](auto frame) { *frame = *edge_frame; });
+		// the edge mask of AWarpSharp made at full, half and quarter size: ASobel and ABlur on a box downscale of the
+		// picture, with the blur narrowed to about the same width in full size samples, then AWarp upsampling its
+		// gradients. each chain is timed as a whole, without the downscale, and its output compared with the full
+		// size chain, the mean and largest difference in 8 bit code values.
+		auto scene = mock.Source(format, width, height, 1, [&](auto frame) { fill_scene(frame, rng); });
+		auto scene_frame = mock.GetFrame(scene, 0);
+		auto chain = [&](auto shift, auto threads) {
+			auto reduced = shift == 0 ? scene : mock.Source(format, width >> shift, height >> shift, 1, [&](auto frame) { box_downscale(scene_frame, frame, shift); });
+			auto sobel_args = VSMap{};
+			MockCore::Arg(sobel_args, "clip", reduced);
+			MockCore::Arg(sobel_args, "threads", std::int64_t{ threads });
+			auto blur_args = VSMap{};
+			MockCore::Arg(blur_args, "clip", MockCore::Clip(mock.Invoke("ASobel", sobel_args)));
+			MockCore::Arg(blur_args, "type", 1ll);
+			MockCore::Arg(blur_args, "blur", std::int64_t{ 4 >> 2 * shift });
+			MockCore::Arg(blur_args, "threads", std::int64_t{ threads });
+			auto warp_args = VSMap{};
+			MockCore::Arg(warp_args, "clip", scene);
+			MockCore::Arg(warp_args, "mask", MockCore::Clip(mock.Invoke("ABlur", blur_args)));
+			MockCore::Arg(warp_args, "depth", 16ll);
+			MockCore::Arg(warp_args, "upsample", std::int64_t{ 1 } << shift);
+			MockCore::Arg(warp_args, "threads", std::int64_t{ threads });
+			return MockCore::Clip(mock.Invoke("AWarp", warp_args));
+		};
+		auto chain_errors = std::vector<std::array<double, 2>>{};
+		auto full_chain = mock.GetFrame(chain(0, 0ll), 0);
+		for (auto shift : { 0, 1, 2 }) {
+			auto output = mock.GetFrame(chain(shift, 0ll), 0);
+			auto [sum, largest] = std::array{ 0., 0. };
+			for (auto plane : Range{ format->numPlanes })
+				for (auto y : Range{ height })
+					for (auto x : Range{ width }) {
+						auto row = [&](auto& frame) { return reinterpret_cast<const float*>(frame->planes[plane].get() + static_cast<std::size_t>(y) * frame->stride[plane]); };
+						auto difference = 255. * std::abs(static_cast<double>(row(output)[x]) - row(full_chain)[x]);
+						sum += difference;
+						largest = std::max(largest, difference);
+					}
+			chain_errors.push_back({ sum / samples, largest });
+		}
+		for (auto threads : thread_counts) {
+			auto run = [&](auto name, auto configure, auto...fields) {
+				auto args = VSMap{};
+				MockCore::Arg(args, "threads", std::int64_t{ threads });
+				configure(args);
+				auto out = mock.Invoke(name, args);
+				if (out.error.empty() == false) {
+					std::cerr << out.error << std::endl;
+					return;
+				}
+				auto node = MockCore::Clip(out);
+				report.Add(measure(budget, [&] { mock.GetFrame(node, 0); }), samples, "bench", "getframe", "filter", name, "resolution", resolution, "width", width, "height", height, "threads", threads, fields...);
+			};
+			run("ASobel", [&](auto& args) { MockCore::Arg(args, "clip", clip); });
+			run("ASobel", [&](auto& args) { MockCore::Arg(args, "clip", word_clip); }, "source", "u16");
+			for (auto blur_type : { 1ll, 0ll }) {
+				auto blur_level = blur_type == 1 ? 3ll : 2ll;
+				run("ABlur", [&](auto& args) {
+					MockCore::Arg(args, "clip", clip);
+					MockCore::Arg(args, "type", std::int64_t{ blur_type });
+					MockCore::Arg(args, "blur", std::int64_t{ blur_level });
+				}, "type", blur_type, "blur", blur_level);
+				run("AWarpSharp", [&](auto& args) {
+					MockCore::Arg(args, "clip", clip);
+					MockCore::Arg(args, "type", std::int64_t{ blur_type });
+					MockCore::Arg(args, "blur", std::int64_t{ blur_level });
+				}, "type", blur_type, "blur", blur_level);
+			}
+			for (auto shift : { 0, 1, 2 }) {
+				auto node = chain(shift, threads);
+				report.Add(measure(budget, [&] { mock.GetFrame(node, 0); }), samples, "bench", "getframe", "filter", "AWarpSharp chain", "resolution", resolution, "width", width, "height", height, "threads", threads,
+					"upsample", 1 << shift, "mean_abs_error", chain_errors[shift][0], "max_abs_error", chain_errors[shift][1]);
+			}
+			for (auto SMAGL : { 0, 1, 2 })
+				if (auto source = std::array{ clip, doubled, upsampled }[SMAGL]; source != nullptr)
+					run("AWarp", [&](auto& args) {
+						MockCore::Arg(args, "clip", source);
+						MockCore::Arg(args, "mask", mask);
+					}, "smagl", SMAGL);
+			for (auto subpixel : { 1ll, 2ll })
+				run("AWarp", [&](auto& args) {
+					MockCore::Arg(args, "clip", clip);
+					MockCore::Arg(args, "mask", mask);
+					MockCore::Arg(args, "subpixel", std::int64_t{ subpixel });
+				}, "smagl", 2, "subpixel", subpixel);
+			run("AWarp", [&](auto& args) {
+				MockCore::Arg(args, "clip", word_clip);
+				MockCore::Arg(args, "mask", mask);
+			}, "smagl", 0, "source", "u16");
+			run("ADisplacement", [&](auto& args) { MockCore::Arg(args, "mask", mask); });
+			run("AWarp", [&](auto& args) {
+				MockCore::Arg(args, "clip", clip);
+				MockCore::Arg(args, "displacement", displacement);
+			}, "smagl", 0, "mask", "displacement");
+			// the bars are flat, so their rows of the edge mask are zero and skipped by ABlur, AWarp and AWarpSharp.
+			run("ABlur", [&](auto& args) {
+				MockCore::Arg(args, "clip", letterboxed_edges);
+				MockCore::Arg(args, "blur", 3ll);
+			}, "type", 1, "blur", 3, "content", "letterbox");
+			run("AWarp", [&](auto& args) {
+				MockCore::Arg(args, "clip", letterboxed);
+				MockCore::Arg(args, "mask", letterboxed_edges);
+			}, "smagl", 0, "content", "letterbox");
+			run("AWarpSharp", [&](auto& args) { MockCore::Arg(args, "clip", letterboxed); }, "type", 1, "blur", 3, "content", "letterbox");
+			// 3 versions of a clip warped along one mask, by one AWarp taking them as an array and by an AWarp each, with
+			// every output fetched.
+			for (auto shared : { true, false }) {
+				auto nodes = std::vector<std::shared_ptr<VSNodeRef>>{};
+				auto make = [&](auto first, auto last) {
+					auto args = VSMap{};
+					for (auto index : Range{ first, last })
+						MockCore::Arg(args, "clip", versions[index]);
+					MockCore::Arg(args, "mask", mask);
+					MockCore::Arg(args, "threads", std::int64_t{ threads });
+					auto out = mock.Invoke("AWarp", args);
+					for (auto index : Range{ MockCore::Count(out, "clip") })
+						nodes.push_back(MockCore::Clip(out, index));
+				};
+				if (shared)
+					make(0, 3);
+				else
+					for (auto index : Range{ 3 })
+						make(index, index + 1);
+				report.Add(measure(budget, [&] { for (auto& x : nodes) mock.GetFrame(x, 0); }), 3 * samples, "bench", "getframe", "filter", "AWarp", "resolution", resolution, "width", width, "height", height, "threads", threads,
+					"smagl", 0, "clips", 3, "nodes", shared ? 1 : 3);
+			}
+			// the kernel sets and strips the tuner picks for this CPU, timed once and then read from the tuning cache.
+			run("AWarpSharp", [&](auto& args) {
+				MockCore::Arg(args, "clip", clip);
+				MockCore::Arg(args, "blur", 3ll);
+				MockCore::Arg(args, "opt", -1ll);
+			}, "type", 1, "blur", 3, "opt", -1);
+			run("AWarp", [&](auto& args) {
+				MockCore::Arg(args, "clip", clip);
+				MockCore::Arg(args, "mask", mask);
+				MockCore::Arg(args, "opt", -1ll);
+			}, "smagl", 0, "opt", -1);
+		}
+	}
+}
\ No newline at end of file
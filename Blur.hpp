@@ -0,0 +1,106 @@
+// included by Core.hpp once per instruction set, inside the matching namespace and target region.
+
+inline auto blur_r6_combine = [](auto center, auto avg12, auto avg34, auto avg56, auto half) {
+	auto avg012 = (center + avg12) * half;
+	auto avg3456 = (avg34 + avg56) * half;
+	auto avg0123456 = (avg012 + avg3456) * half;
+	return (avg012 + avg0123456) * half;
+};
+
+inline auto blur_r6_partial_kernel = [](auto fetch, auto step, auto half) {
+	auto avg = [&](auto k) { return (fetch(k * step) + fetch((k + 1) * step)) * half; };
+	return blur_r6_combine(fetch(0), avg(1), avg(3), avg(5), half);
+};
+
+inline auto blur_r6_complete_kernel = [](auto fetch, auto half) {
+	auto avg = [&](auto k) { return (fetch(-k) + fetch(k)) * half; };
+	auto avg12 = (avg(1) + avg(2)) * half;
+	auto avg34 = (avg(3) + avg(4)) * half;
+	auto avg56 = (avg(5) + avg(6)) * half;
+	return blur_r6_combine(fetch(0), avg12, avg34, avg56, half);
+};
+
+inline auto blur_r6_horizontal = [](auto mask, auto temp, auto width) {
+	auto half = broadcast(.5f);
+	for (auto x : Range{ 6 })
+		temp[x] = blur_r6_partial_kernel([&](auto k) { return mask[x + k]; }, 1, .5f);
+	for_each_group(6, width - 6, [&](auto x, auto...tail) {
+		store(temp + x, blur_r6_complete_kernel([&](auto k) { return load(mask + x + k, tail...); }, half), tail...);
+	});
+	for (auto x : Range{ width - 6, width })
+		temp[x] = blur_r6_partial_kernel([&](auto k) { return mask[x + k]; }, -1, .5f);
+};
+
+inline auto blur_r6_vertical = [](auto rows, auto mask, auto width, auto y, auto height) {
+	auto temp = rows + 6;
+	auto half = broadcast(.5f);
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		auto fetch = [&](auto k) { return load(temp[k] + x, tail...); };
+		if (y < 6)
+			store(mask + x, blur_r6_partial_kernel(fetch, 1, half), tail...);
+		else if (y < height - 6)
+			store(mask + x, blur_r6_complete_kernel(fetch, half), tail...);
+		else
+			store(mask + x, blur_r6_partial_kernel(fetch, -1, half), tail...);
+	});
+};
+
+inline auto blur_r2_kernel = [](auto center, auto prev1, auto next1, auto prev2, auto next2, auto half, auto quarter, auto three) {
+	auto avg1 = (prev1 + next1) * half;
+	auto avg2 = (prev2 + next2) * half;
+	return ((center * three + avg2) * quarter + avg1) * half;
+};
+
+inline auto blur_r2_horizontal = [](auto mask, auto temp, auto width) {
+	auto half = broadcast(.5f);
+	auto quarter = broadcast(.25f);
+	auto three = broadcast(3.f);
+	auto scalar_kernel = [](auto p, auto offset_p1, auto offset_n1, auto offset_p2, auto offset_n2) {
+		return blur_r2_kernel(p[0], p[offset_p1], p[offset_n1], p[offset_p2], p[offset_n2], .5f, .25f, 3.f);
+	};
+	temp[0] = scalar_kernel(mask, 0, 1, 0, 2);
+	temp[1] = scalar_kernel(mask + 1, -1, 1, -1, 2);
+	for_each_group(2, width - 2, [&](auto x, auto...tail) {
+		auto fetch = [&](auto k) { return load(mask + x + k, tail...); };
+		store(temp + x, blur_r2_kernel(fetch(0), fetch(-1), fetch(1), fetch(-2), fetch(2), half, quarter, three), tail...);
+	});
+	temp[width - 2] = scalar_kernel(mask + width - 2, -1, 1, -2, 1);
+	temp[width - 1] = scalar_kernel(mask + width - 1, -1, 0, -2, 0);
+};
+
+inline auto blur_r2_vertical = [](auto rows, auto mask, auto width, [[maybe_unused]] auto y, [[maybe_unused]] auto height) {
+	auto temp = rows + 2;
+	auto half = broadcast(.5f);
+	auto quarter = broadcast(.25f);
+	auto three = broadcast(3.f);
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		auto fetch = [&](auto k) { return load(temp[k] + x, tail...); };
+		store(mask + x, blur_r2_kernel(fetch(0), fetch(-1), fetch(1), fetch(-2), fetch(2), half, quarter, three), tail...);
+	});
+};
+
+inline auto blur_fir_sum = [](auto count, auto fetch, auto coefficients) {
+	auto sums = std::array{ fetch(0) * broadcast(coefficients[0]), broadcast(0.f), broadcast(0.f), broadcast(0.f) };
+	for (auto i : Range{ 1, count })
+		sums[i % 4] = fmadd(fetch(i), broadcast(coefficients[i]), sums[i % 4]);
+	return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+};
+
+inline auto blur_fir_horizontal = [](auto& taps, auto mask, auto temp, auto width) {
+	auto radius = taps.radius;
+	auto coefficients = taps.interior_single.data();
+	for (auto x : Range{ radius }) {
+		temp[x] = blur_fir_edge(taps, x, [&](auto j) { return mask[j]; });
+		temp[width - 1 - x] = blur_fir_edge(taps, x, [&](auto j) { return mask[width - 1 - j]; });
+	}
+	for_each_group(radius, width - radius, [&](auto x, auto...tail) {
+		store(temp + x, blur_fir_sum(2 * radius + 1, [&](auto k) { return load(mask + x - radius + k, tail...); }, coefficients), tail...);
+	});
+};
+
+inline auto blur_fir_vertical = [](auto& taps, auto rows, auto mask, auto width, auto y, auto height) {
+	auto coefficients = blur_fir_window(taps.interior_single, taps.windows_single, taps.radius, y, height);
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		store(mask + x, blur_fir_sum(2 * taps.radius + 1, [&](auto i) { return load(rows[i] + x, tail...); }, coefficients), tail...);
+	});
+};
\ No newline at end of file
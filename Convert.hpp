@@ -0,0 +1,10 @@
+// included by Core.hpp once per instruction set, inside the matching namespace and target region.
+// half float and integer masks are widened to float rows before the kernels see them and narrowed again on the way
+// out, converting in registers on load and store, so every other kernel keeps working on float rows.
+
+inline auto convert_row = [](auto srcp, auto dstp, auto width, auto scale) {
+	auto factor = broadcast(scale);
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		store(dstp + x, load(srcp + x, tail...) * factor, tail...);
+	});
+};
\ No newline at end of file
@@ -0,0 +1,1416 @@
+#pragma once
+#include "Cosmetics.hpp"
+#include "SIMD.hpp"
+#include "Parallel.hpp"
+#include "Arena.hpp"
+#include "Tune.hpp"
+
+namespace warpsf {
+
+// the filters without VapourSynth: kernels, the row and plane loops around them and entry points over frames in
+// caller-owned buffers, header only and free of any VapourSynth header, so an application that includes this file
+// alone builds with the same flags as the plugin. the plugin in Source.cpp is a wrapper around it. all of it is in
+// namespace warpsf, and the only macros left defined after it are the WARPSF_ ones.
+
+// blur passes repeated blur_level times, collapsed into one separable FIR of radius blur_level * pass radius.
+// interior holds the taps away from the borders, edge holds one row per output position closer than radius to the
+// first sample, over inputs [0, 2 * radius). the last samples use the same rows mirrored. windows holds the weights
+// of the rows closer than radius to the top and then of those closer than radius to the bottom, each over the 2 *
+// radius + 1 rows around it, so the vertical pass only picks a row of them. the single precision kernels take the
+// float copies.
+struct BlurTaps final {
+	self(radius, 0_ptrdiff);
+	self(interior, std::vector<double>{});
+	self(edge, std::vector<double>{});
+	self(windows, std::vector<double>{});
+	self(interior_single, std::vector<float>{});
+	self(windows_single, std::vector<float>{});
+};
+
+inline auto collapse_blur = [](auto blur_type, auto blur_level) {
+	auto taps = BlurTaps{};
+	auto pass_radius = blur_type == 0 ? 6_ptrdiff : 2_ptrdiff;
+	taps.radius = blur_level * pass_radius;
+	auto length = 4 * taps.radius + 1;
+	auto pass = [&](auto x, auto& weights, auto& result) {
+		auto tap = [&](auto i, auto w) { result[std::clamp<std::ptrdiff_t>(i, 0, length - 1)] += weights[x] * w; };
+		tap(x, 3. / 8.);
+		if (blur_type == 1)
+			for (auto k : { -1, 1 }) {
+				tap(x + k, 1. / 4.);
+				tap(x + 2 * k, 1. / 16.);
+			}
+		else if (auto step = x < 6 ? 1 : x >= length - 6 ? -1 : 0; step != 0)
+			for (auto k : Range{ 1, 7 })
+				tap(x + k * step, k < 3 ? 3. / 16. : 1. / 16.);
+		else
+			for (auto k : Range{ 1, 7 })
+				for (auto side : { -1, 1 })
+					tap(x + k * side, k < 3 ? 3. / 32. : 1. / 32.);
+	};
+	auto collapsed_row = [&](auto y) {
+		auto weights = std::vector<double>(length);
+		weights[y] = 1.;
+		for ([[maybe_unused]] auto _ : Range{ blur_level }) {
+			auto result = std::vector<double>(length);
+			for (auto x : Range{ length })
+				if (weights[x] != 0.)
+					pass(x, weights, result);
+			weights = std::move(result);
+		}
+		return weights;
+	};
+	auto center = collapsed_row(2 * taps.radius);
+	taps.interior.assign(center.begin() + taps.radius, center.begin() + 3 * taps.radius + 1);
+	for (auto y : Range{ taps.radius }) {
+		auto row = collapsed_row(y);
+		taps.edge.insert(taps.edge.end(), row.begin(), row.begin() + 2 * taps.radius);
+	}
+	auto window = 2 * taps.radius + 1;
+	taps.windows.resize(2 * taps.radius * window);
+	for (auto k : Range{ taps.radius })
+		for (auto j : Range{ k + taps.radius + 1 }) {
+			taps.windows[k * window + j - k + taps.radius] = taps.edge[k * 2 * taps.radius + j];
+			taps.windows[(taps.radius + k) * window + taps.radius + k - j] = taps.edge[k * 2 * taps.radius + j];
+		}
+	taps.interior_single.assign(taps.interior.begin(), taps.interior.end());
+	taps.windows_single.assign(taps.windows.begin(), taps.windows.end());
+	return taps;
+};
+
+inline auto eval_multi = [](auto action, auto...params) {
+	auto results = std::array<double, sizeof...(params)>{};
+	auto cursor = results.data();
+	auto eval = [&](auto& ycomb, auto p, auto...rest) {
+		*cursor = action(p);
+		++cursor;
+		if constexpr (sizeof...(rest) != 0)
+			ycomb(ycomb, rest...);
+	};
+	if constexpr (sizeof...(params) != 0)
+		eval(eval, params...);
+	return results;
+};
+
+inline auto zip = [](auto...p) {
+	return eval_multi([](auto x) {return x; }, p...);
+};
+
+inline auto avg_multi = [](auto...pairs) {
+	return eval_multi([](auto x) {return (x[0] + x[1]) / 2.; }, pairs...);
+};
+
+inline auto sobel_row = [](auto above, auto center, auto below, auto dstp, auto width, auto thresh, auto peak) {
+	for (auto x : Range{ 1, width - 1 }) {
+		auto [avg_up, avg_down, avg_left, avg_right] = eval_multi(
+			[](auto x) {return (x[0] + (x[1] + x[2]) / 2.) / 2.; },
+			zip(above[x], above[x - 1], above[x + 1]),
+			zip(below[x], below[x - 1], below[x + 1]),
+			zip(center[x - 1], below[x - 1], above[x - 1]),
+			zip(center[x + 1], below[x + 1], above[x + 1]));
+		auto [abs_v, abs_h] = eval_multi([](auto x) {return std::abs(x); }, avg_up - avg_down, avg_left - avg_right);
+		auto abs_max = std::max(abs_h, abs_v);
+		dstp[x] = static_cast<float>(std::min((abs_v + abs_h + abs_max) * 6. / peak, thresh));
+	}
+	dstp[0] = dstp[1];
+	dstp[width - 1] = dstp[width - 2];
+};
+
+inline auto blur_r6_partial_kernel = [](auto center, auto...pairs) {
+	auto [avg12, avg34, avg56] = avg_multi(pairs...);
+	auto [avg012, avg3456] = avg_multi(zip(center, avg12), zip(avg34, avg56));
+	auto [avg0123456] = avg_multi(zip(avg012, avg3456));
+	return static_cast<float>((avg012 + avg0123456) / 2.);
+};
+
+inline auto blur_r6_complete_kernel = [](auto center, auto...pairs) {
+	auto [avg11, avg22, avg33, avg44, avg55, avg66] = avg_multi(pairs...);
+	auto [avg12, avg34, avg56] = avg_multi(zip(avg11, avg22), zip(avg33, avg44), zip(avg55, avg66));
+	auto [avg012, avg3456] = avg_multi(zip(center, avg12), zip(avg34, avg56));
+	auto [avg0123456] = avg_multi(zip(avg012, avg3456));
+	return static_cast<float>((avg012 + avg0123456) / 2.);
+};
+
+inline auto blur_r6_horizontal = [](auto mask, auto temp, auto width) {
+	for (auto x : Range{ 6 })
+		temp[x] = blur_r6_partial_kernel(mask[x], zip(mask[x + 1], mask[x + 2]), zip(mask[x + 3], mask[x + 4]), zip(mask[x + 5], mask[x + 6]));
+	for (auto x : Range{ 6, width - 6 })
+		temp[x] = blur_r6_complete_kernel(mask[x], zip(mask[x - 1], mask[x + 1]), zip(mask[x - 2], mask[x + 2]), zip(mask[x - 3], mask[x + 3]),
+			zip(mask[x - 4], mask[x + 4]), zip(mask[x - 5], mask[x + 5]), zip(mask[x - 6], mask[x + 6]));
+	for (auto x : Range{ width - 6, width })
+		temp[x] = blur_r6_partial_kernel(mask[x], zip(mask[x - 1], mask[x - 2]), zip(mask[x - 3], mask[x - 4]), zip(mask[x - 5], mask[x - 6]));
+};
+
+inline auto blur_r6_vertical = [](auto rows, auto mask, auto width, auto y, auto height) {
+	auto temp = rows + 6;
+	if (y < 6)
+		for (auto x : Range{ width })
+			mask[x] = blur_r6_partial_kernel(temp[0][x], zip(temp[1][x], temp[2][x]), zip(temp[3][x], temp[4][x]), zip(temp[5][x], temp[6][x]));
+	else if (y < height - 6)
+		for (auto x : Range{ width })
+			mask[x] = blur_r6_complete_kernel(temp[0][x], zip(temp[-1][x], temp[1][x]), zip(temp[-2][x], temp[2][x]), zip(temp[-3][x], temp[3][x]),
+				zip(temp[-4][x], temp[4][x]), zip(temp[-5][x], temp[5][x]), zip(temp[-6][x], temp[6][x]));
+	else
+		for (auto x : Range{ width })
+			mask[x] = blur_r6_partial_kernel(temp[0][x], zip(temp[-1][x], temp[-2][x]), zip(temp[-3][x], temp[-4][x]), zip(temp[-5][x], temp[-6][x]));
+};
+
+inline auto blur_r2_kernel = [](auto center, auto...pairs) {
+	auto [avg1, avg2] = avg_multi(pairs...);
+	auto avg = (avg2 + 3. * center) / 4.;
+	return static_cast<float>((avg + avg1) / 2.);
+};
+
+inline auto blur_r2_horizontal = [](auto mask, auto temp, auto width) {
+	temp[0] = blur_r2_kernel(mask[0], zip(mask[0], mask[1]), zip(mask[0], mask[2]));
+	temp[1] = blur_r2_kernel(mask[1], zip(mask[0], mask[2]), zip(mask[0], mask[3]));
+	for (auto x : Range{ 2, width - 2 })
+		temp[x] = blur_r2_kernel(mask[x], zip(mask[x - 1], mask[x + 1]), zip(mask[x - 2], mask[x + 2]));
+	temp[width - 2] = blur_r2_kernel(mask[width - 2], zip(mask[width - 3], mask[width - 1]), zip(mask[width - 4], mask[width - 1]));
+	temp[width - 1] = blur_r2_kernel(mask[width - 1], zip(mask[width - 2], mask[width - 1]), zip(mask[width - 3], mask[width - 1]));
+};
+
+inline auto blur_r2_vertical = [](auto rows, auto mask, auto width, [[maybe_unused]] auto y, [[maybe_unused]] auto height) {
+	auto temp = rows + 2;
+	for (auto x : Range{ width })
+		mask[x] = blur_r2_kernel(temp[0][x], zip(temp[-1][x], temp[1][x]), zip(temp[-2][x], temp[2][x]));
+};
+inline auto blur_fir_edge = [](auto& taps, auto k, auto fetch) {
+	auto sum = 0.;
+	for (auto j : Range{ 2 * taps.radius })
+		sum += taps.edge[k * 2 * taps.radius + j] * fetch(j);
+	return static_cast<float>(sum);
+};
+// the weights of output row y over the 2 * radius + 1 rows around it, from interior or windows of either precision.
+inline auto blur_fir_window = [](auto& interior, auto& windows, auto radius, auto y, auto height) {
+	auto window = 2 * radius + 1;
+	if (y < radius)
+		return windows.data() + y * window;
+	else if (auto k = height - 1 - y; k < radius)
+		return windows.data() + (radius + k) * window;
+	return interior.data();
+};
+inline auto blur_fir_horizontal = [](auto& taps, auto mask, auto temp, auto width) {
+	auto radius = taps.radius;
+	for (auto x : Range{ radius }) {
+		temp[x] = blur_fir_edge(taps, x, [&](auto j) { return mask[j]; });
+		temp[width - 1 - x] = blur_fir_edge(taps, x, [&](auto j) { return mask[width - 1 - j]; });
+	}
+	for (auto x : Range{ radius, width - radius }) {
+		auto sum = 0.;
+		for (auto k : Range{ 2 * radius + 1 })
+			sum += taps.interior[k] * mask[x - radius + k];
+		temp[x] = static_cast<float>(sum);
+	}
+};
+inline auto blur_fir_vertical = [](auto& taps, auto rows, auto mask, auto width, auto y, auto height) {
+	auto weights = blur_fir_window(taps.interior, taps.windows, taps.radius, y, height);
+	for (auto x : Range{ width }) {
+		auto sum = 0.;
+		for (auto i : Range{ 2 * taps.radius + 1 })
+			sum += weights[i] * rows[i][x];
+		mask[x] = static_cast<float>(sum);
+	}
+};
+
+inline auto warp_row = [](auto srcp, auto above, auto edgep, auto below, auto dstp, auto src_stride, auto width, auto y, auto height, auto depth, auto SMAGL, auto ssw, auto ssh) {
+	auto SMAG = 1 << SMAGL;
+	auto x_limit_max = static_cast<long long>(width - 1)* SMAG;
+	auto mask_width = static_cast<long long>(width) << ssw;
+	depth <<= 8;
+	for (auto x : Range{ width }) {
+		auto center = x << ssw;
+		auto left = center == 0 ? edgep[center] : edgep[center - 1];
+		auto right = center == mask_width - 1 ? edgep[center] : edgep[center + 1];
+		auto calc_hv = [=](auto x) {
+			auto scaled = static_cast<long long>(nearbyintl(x * 256.));
+			scaled <<= 7;
+			scaled *= depth;
+			return scaled >> 16;
+		};
+		auto calc_remainder = [=](auto x) {
+			if (SMAGL != 0)
+				x <<= SMAGL;
+			return static_cast<double>(x & 127);
+		};
+		auto weighted_avg = [](auto x) {return (x[0] * (128. - x[2]) + x[1] * x[2]) / 128.; };
+		auto h = calc_hv(left - right) >> ssw, v = calc_hv(above[center] - below[center]) >> ssh;
+		v = std::min(std::max(v, -y * 128ll), (height - y) * 128ll - 129);
+		auto [remainder_h, remainder_v] = eval_multi(calc_remainder, h, v);
+		h >>= 7 - SMAGL;
+		v >>= 7 - SMAGL;
+		h += x << SMAGL;
+		if (auto remainder_needed = (x_limit_max > h) && !(h < 0); remainder_needed == false)
+			remainder_h = 0.;
+		h = std::max(std::min(h, x_limit_max), 0ll);
+		auto h_right = std::min(h + 1, x_limit_max);
+		auto [s0, s1] = eval_multi(weighted_avg, zip(srcp[v * src_stride + h], srcp[v * src_stride + h_right], remainder_h),
+			zip(srcp[(v + 1) * src_stride + h], srcp[(v + 1) * src_stride + h_right], remainder_h));
+		if constexpr (auto value = weighted_avg(zip(s0, s1, remainder_v)); std::is_integral_v<std::decay_t<decltype(*dstp)>>)
+			dstp[x] = static_cast<std::decay_t<decltype(*dstp)>>(std::floor(value + .5));
+		else
+			dstp[x] = static_cast<float>(value);
+	}
+};
+
+// subpixel reference: each of the 2x2 samples of the 4x upscale around the warped position is worked out from the
+// source on its own, straight from the definition of the bilinear or bicubic (b = c = 1/3) upscale with centred samples.
+inline auto warp_resampled_row = [](auto srcp, auto gradient_h, auto gradient_v, auto dstp, auto src_stride, auto width, auto first_x, auto last_x, auto y, auto height, auto depth, auto ssw, auto ssh, auto taps, auto peak) {
+	auto x_limit_max = static_cast<long long>(width - 1) * 4;
+	auto kernel = [=](auto distance) {
+		auto [b, c] = std::array{ 1. / 3., 1. / 3. };
+		distance = std::abs(distance);
+		if (taps == 2)
+			return std::max(1. - distance, 0.);
+		if (distance < 1.)
+			return ((12. - 9. * b - 6. * c) * distance * distance * distance + (-18. + 12. * b + 6. * c) * distance * distance + (6. - 2. * b)) / 6.;
+		if (distance < 2.)
+			return ((-b - 6. * c) * distance * distance * distance + (6. * b + 30. * c) * distance * distance + (-12. * b - 48. * c) * distance + (8. * b + 24. * c)) / 6.;
+		return 0.;
+	};
+	auto upscaled = [&](auto row, auto column) {
+		auto [source_y, source_x] = std::array{ (row + .5) / 4. - .5, (column + .5) / 4. - .5 };
+		auto [first_y, first_x] = std::array{ static_cast<long long>(std::floor(source_y)) - taps / 2 + 1, static_cast<long long>(std::floor(source_x)) - taps / 2 + 1 };
+		auto sum = 0.;
+		for (auto i : Range{ first_y, first_y + taps, 1 })
+			for (auto j : Range{ first_x, first_x + taps, 1 })
+				sum += kernel(source_y - i) * kernel(source_x - j) * srcp[std::clamp(static_cast<long long>(i), 0ll, height - 1ll) * src_stride + std::clamp(static_cast<long long>(j), 0ll, width - 1ll)];
+		return sum;
+	};
+	for (auto x : Range{ first_x, last_x, 1 }) {
+		auto calc_hv = [=](auto scaled) { return ((static_cast<long long>(scaled) << 7) * (depth << 8)) >> 16; };
+		auto h = calc_hv(gradient_h[x << ssw]) >> ssw, v = calc_hv(gradient_v[x << ssw]) >> ssh;
+		v = std::min(std::max(v, -y * 128ll), (height - y) * 128ll - 129);
+		auto [remainder_h, remainder_v] = std::array{ static_cast<double>((h << 2) & 127), static_cast<double>((v << 2) & 127) };
+		h = (h >> 5) + x * 4ll;
+		v = (v >> 5) + y * 4ll;
+		if (auto remainder_needed = (x_limit_max > h) && !(h < 0); remainder_needed == false)
+			remainder_h = 0.;
+		h = std::max(std::min(h, x_limit_max), 0ll);
+		auto h_right = std::min(h + 1, x_limit_max);
+		auto s0 = (upscaled(v, h) * (128. - remainder_h) + upscaled(v, h_right) * remainder_h) / 128.;
+		auto s1 = (upscaled(v + 1, h) * (128. - remainder_h) + upscaled(v + 1, h_right) * remainder_h) / 128.;
+		if constexpr (auto value = (s0 * (128. - remainder_v) + s1 * remainder_v) / 128.; std::is_integral_v<std::decay_t<decltype(*dstp)>>)
+			dstp[x] = static_cast<std::decay_t<decltype(*dstp)>>(std::floor(std::clamp(value, 0., static_cast<double>(peak)) + .5));
+		else
+			dstp[x] = static_cast<float>(value);
+	}
+};
+
+namespace Portable {
+#include "Sobel.hpp"
+#include "Blur.hpp"
+#include "Warp.hpp"
+#include "Convert.hpp"
+}
+
+#ifdef WARPSF_X86
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+WARPSF_TARGET_BEGIN("sse2")
+namespace SSE2 {
+#include "Sobel.hpp"
+#include "Blur.hpp"
+#include "Convert.hpp"
+}
+WARPSF_TARGET_END
+
+WARPSF_TARGET_BEGIN("avx2,fma,f16c")
+namespace AVX2 {
+#include "Sobel.hpp"
+#include "Blur.hpp"
+#include "Warp.hpp"
+#include "Convert.hpp"
+}
+WARPSF_TARGET_END
+
+WARPSF_TARGET_BEGIN("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma")
+namespace AVX512 {
+#include "Sobel.hpp"
+#include "Blur.hpp"
+#include "Warp.hpp"
+#include "Convert.hpp"
+}
+WARPSF_TARGET_END
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+template<typename Sample>
+using SobelRow = void(*)(const Sample*, const Sample*, const Sample*, float*, int, double, double);
+using BlurRow = void(*)(const float*, float*, int);
+using BlurColumn = void(*)(const float* const*, float*, int, int, int);
+using BlurFirRow = void(*)(const BlurTaps&, const float*, float*, int);
+using BlurFirColumn = void(*)(const BlurTaps&, const float* const*, float*, int, int, int);
+template<typename Sample>
+using WarpRow = void(*)(const Sample*, const float*, const float*, const float*, Sample*, int, int, int, int, long long, int, int, int);
+using GradientRow = void(*)(const float*, const float*, const float*, int*, int*, int);
+template<typename Sample>
+using WarpGradientRow = void(*)(const Sample*, const int*, const int*, Sample*, int, int, int, int, int, int, long long, int, int, int);
+using DisplacementRow = void(*)(const int*, const int*, int*, int*, int, long long, int, int);
+using UpsampleGradientRow = void(*)(const int*, const int*, const int*, const int*, int, int*, int*, int*, int*, int, int, int);
+template<typename Sample>
+using WarpResampledRow = void(*)(const Sample*, const int*, const int*, Sample*, int, int, int, int, int, int, long long, int, int, int, float);
+template<typename Sample>
+using WidenRow = void(*)(const Sample*, float*, int, float);
+template<typename Sample>
+using NarrowRow = void(*)(const float*, Sample*, int, float);
+
+struct KernelSet final {
+	self(sobel_row, static_cast<SobelRow<float>>(nullptr));
+	self(sobel_byte, static_cast<SobelRow<std::uint8_t>>(nullptr));
+	self(sobel_word, static_cast<SobelRow<std::uint16_t>>(nullptr));
+	self(blur_horizontal, static_cast<BlurRow>(nullptr));
+	self(blur_vertical, static_cast<BlurColumn>(nullptr));
+	self(blur_radius, 0);
+	self(blur_fir_horizontal, static_cast<BlurFirRow>(nullptr));
+	self(blur_fir_vertical, static_cast<BlurFirColumn>(nullptr));
+	self(warp_row, static_cast<WarpRow<float>>(nullptr));
+	self(warp_byte, static_cast<WarpRow<std::uint8_t>>(nullptr));
+	self(warp_word, static_cast<WarpRow<std::uint16_t>>(nullptr));
+	// warp_gradient_* and displacement_row are null in the double precision reference, which warps each plane straight
+	// from the mask unless it samples the source at subpixel positions.
+	self(gradient_row, static_cast<GradientRow>(nullptr));
+	self(warp_gradient_row, static_cast<WarpGradientRow<float>>(nullptr));
+	self(warp_gradient_byte, static_cast<WarpGradientRow<std::uint8_t>>(nullptr));
+	self(warp_gradient_word, static_cast<WarpGradientRow<std::uint16_t>>(nullptr));
+	self(displacement_row, static_cast<DisplacementRow>(nullptr));
+	self(upsample_gradient_row, static_cast<UpsampleGradientRow>(nullptr));
+	self(warp_resampled_row, static_cast<WarpResampledRow<float>>(nullptr));
+	self(warp_resampled_byte, static_cast<WarpResampledRow<std::uint8_t>>(nullptr));
+	self(warp_resampled_word, static_cast<WarpResampledRow<std::uint16_t>>(nullptr));
+	self(widen_half, static_cast<WidenRow<Half>>(nullptr));
+	self(widen_byte, static_cast<WidenRow<std::uint8_t>>(nullptr));
+	self(widen_word, static_cast<WidenRow<std::uint16_t>>(nullptr));
+	self(narrow_half, static_cast<NarrowRow<Half>>(nullptr));
+	self(narrow_byte, static_cast<NarrowRow<std::uint8_t>>(nullptr));
+	self(narrow_word, static_cast<NarrowRow<std::uint16_t>>(nullptr));
+};
+
+struct CollapsedBlur final {
+	self(kernels, static_cast<const KernelSet*>(nullptr));
+	self(taps, static_cast<const BlurTaps*>(nullptr));
+	self(blur_radius, 0_ptrdiff);
+	auto blur_horizontal(const float* mask, float* temp, int width) const {
+		kernels->blur_fir_horizontal(*taps, mask, temp, width);
+	}
+	auto blur_vertical(const float* const* rows, float* mask, int width, int y, int height) const {
+		kernels->blur_fir_vertical(*taps, rows, mask, width, y, height);
+	}
+};
+
+inline auto select_kernels = [](auto isa, auto blur_type, auto single) {
+	auto kernels = KernelSet{};
+	auto assign = [&](auto sobel_row, auto blur_r6_horizontal, auto blur_r6_vertical, auto blur_r2_horizontal, auto blur_r2_vertical, auto blur_fir_horizontal, auto blur_fir_vertical, auto warp_row, auto gradient_row, auto warp_gradient_row, auto displacement_row, auto upsample_gradient_row, auto warp_resampled_row, auto convert_row) {
+		kernels.sobel_row = sobel_row;
+		kernels.sobel_byte = sobel_row;
+		kernels.sobel_word = sobel_row;
+		kernels.blur_horizontal = blur_type == 0 ? BlurRow{ blur_r6_horizontal } : BlurRow{ blur_r2_horizontal };
+		kernels.blur_vertical = blur_type == 0 ? BlurColumn{ blur_r6_vertical } : BlurColumn{ blur_r2_vertical };
+		kernels.blur_radius = blur_type == 0 ? 6 : 2;
+		kernels.blur_fir_horizontal = blur_fir_horizontal;
+		kernels.blur_fir_vertical = blur_fir_vertical;
+		kernels.warp_row = warp_row;
+		kernels.warp_byte = warp_row;
+		kernels.warp_word = warp_row;
+		kernels.gradient_row = gradient_row;
+		kernels.warp_gradient_row = warp_gradient_row;
+		kernels.warp_gradient_byte = warp_gradient_row;
+		kernels.warp_gradient_word = warp_gradient_row;
+		kernels.displacement_row = displacement_row;
+		kernels.upsample_gradient_row = upsample_gradient_row;
+		kernels.warp_resampled_row = warp_resampled_row;
+		kernels.warp_resampled_byte = warp_resampled_row;
+		kernels.warp_resampled_word = warp_resampled_row;
+		kernels.widen_half = convert_row;
+		kernels.widen_byte = convert_row;
+		kernels.widen_word = convert_row;
+		kernels.narrow_half = convert_row;
+		kernels.narrow_byte = convert_row;
+		kernels.narrow_word = convert_row;
+	};
+	assign(sobel_row, blur_r6_horizontal, blur_r6_vertical, blur_r2_horizontal, blur_r2_vertical, blur_fir_horizontal, blur_fir_vertical, warp_row, Portable::gradient_row, nullptr, nullptr, Portable::upsample_gradient_row, warp_resampled_row, Portable::convert_row);
+	if (single == false)
+		return kernels;
+	assign(Portable::sobel_row, Portable::blur_r6_horizontal, Portable::blur_r6_vertical, Portable::blur_r2_horizontal, Portable::blur_r2_vertical, Portable::blur_fir_horizontal, Portable::blur_fir_vertical, Portable::warp_row, Portable::gradient_row, Portable::warp_gradient_row, Portable::displacement_row, Portable::upsample_gradient_row, Portable::warp_resampled_row, Portable::convert_row);
+#ifdef WARPSF_X86
+	if (isa == ISA::SSE2)
+		assign(SSE2::sobel_row, SSE2::blur_r6_horizontal, SSE2::blur_r6_vertical, SSE2::blur_r2_horizontal, SSE2::blur_r2_vertical, SSE2::blur_fir_horizontal, SSE2::blur_fir_vertical, Portable::warp_row, Portable::gradient_row, Portable::warp_gradient_row, Portable::displacement_row, Portable::upsample_gradient_row, Portable::warp_resampled_row, SSE2::convert_row);
+	if (isa == ISA::AVX2)
+		assign(AVX2::sobel_row, AVX2::blur_r6_horizontal, AVX2::blur_r6_vertical, AVX2::blur_r2_horizontal, AVX2::blur_r2_vertical, AVX2::blur_fir_horizontal, AVX2::blur_fir_vertical, AVX2::warp_row, AVX2::gradient_row, AVX2::warp_gradient_row, AVX2::displacement_row, AVX2::upsample_gradient_row, AVX2::warp_resampled_row, AVX2::convert_row);
+	if (isa == ISA::AVX512)
+		assign(AVX512::sobel_row, AVX512::blur_r6_horizontal, AVX512::blur_r6_vertical, AVX512::blur_r2_horizontal, AVX512::blur_r2_vertical, AVX512::blur_fir_horizontal, AVX512::blur_fir_vertical, AVX512::warp_row, AVX512::gradient_row, AVX512::warp_gradient_row, AVX512::displacement_row, AVX512::upsample_gradient_row, AVX512::warp_resampled_row, AVX512::convert_row);
+#endif
+	return kernels;
+};
+
+// the kernel set of a tuning: sobel and blur kernels from the instruction sets picked for them, everything else,
+// including the mask conversions, from the one picked for warp.
+inline auto select_tuned_kernels = [](auto& tuning, auto blur_type, auto single) {
+	auto kernels = select_kernels(tuning.warp, blur_type, single);
+	auto sobel = select_kernels(tuning.sobel, blur_type, single);
+	auto blur = select_kernels(tuning.blur, blur_type, single);
+	kernels.sobel_row = sobel.sobel_row;
+	kernels.sobel_byte = sobel.sobel_byte;
+	kernels.sobel_word = sobel.sobel_word;
+	kernels.blur_horizontal = blur.blur_horizontal;
+	kernels.blur_vertical = blur.blur_vertical;
+	kernels.blur_fir_horizontal = blur.blur_fir_horizontal;
+	kernels.blur_fir_vertical = blur.blur_fir_vertical;
+	return kernels;
+};
+
+enum class Storage {
+	Float,
+	Half,
+	Byte,
+	Word
+};
+
+// how a plane stores its samples. float masks are read and written in place, half float masks and integer masks
+// holding round(value * peak) go through one float row of scratch, so the mask kernels only ever see floats in [0, 1].
+// sources are float or integer, and ASobel and AWarp read integer sources natively.
+struct PlaneSamples final {
+	self(storage, Storage::Float);
+	self(peak, 1.f);
+	PlaneSamples() = default;
+	// samples of 16 or 32 bit floats, or integers of bits bits.
+	PlaneSamples(bool floating, int bits) {
+		if (floating)
+			storage = bits == 32 ? Storage::Float : Storage::Half;
+		else {
+			storage = bits <= 8 ? Storage::Byte : Storage::Word;
+			peak = static_cast<float>((1 << bits) - 1);
+		}
+	}
+	auto Converted() const {
+		return storage != Storage::Float;
+	}
+	auto SampleBytes() const {
+		return storage == Storage::Float ? 4 : storage == Storage::Byte ? 1 : 2;
+	}
+	// row as floats, widened into scratch unless the plane already holds floats.
+	auto Widen(const KernelSet& kernels, const std::uint8_t* srcp, int width, float* scratch) const {
+		if (storage == Storage::Half)
+			kernels.widen_half(reinterpret_cast<const Half*>(srcp), scratch, width, 1.f);
+		else if (storage == Storage::Byte)
+			kernels.widen_byte(srcp, scratch, width, 1.f / peak);
+		else if (storage == Storage::Word)
+			kernels.widen_word(reinterpret_cast<const std::uint16_t*>(srcp), scratch, width, 1.f / peak);
+		else
+			return reinterpret_cast<const float*>(srcp);
+		return static_cast<const float*>(scratch);
+	}
+	// stores a float row computed in scratch, a no-op when it was computed in place.
+	auto Narrow(const KernelSet& kernels, const float* row, int width, std::uint8_t* dstp) const {
+		if (storage == Storage::Half)
+			kernels.narrow_half(row, reinterpret_cast<Half*>(dstp), width, 1.f);
+		else if (storage == Storage::Byte)
+			kernels.narrow_byte(row, dstp, width, peak);
+		else if (storage == Storage::Word)
+			kernels.narrow_word(row, reinterpret_cast<std::uint16_t*>(dstp), width, peak);
+		else if (row != reinterpret_cast<const float*>(dstp))
+			std::memcpy(dstp, row, width * sizeof(float));
+	}
+	// where a kernel should write row y of the plane: in place for floats, scratch otherwise.
+	auto Target(std::uint8_t* dstp, float* scratch) const {
+		return Converted() ? scratch : reinterpret_cast<float*>(dstp);
+	}
+};
+
+inline auto clamp_row = [](auto y, auto height) {
+	return std::clamp<std::ptrdiff_t>(y, 0, height - 1);
+};
+
+inline auto split_rows = [](auto threads, auto height, auto halo) {
+	auto bands = std::min<std::ptrdiff_t>(threads, height / std::max<std::ptrdiff_t>(4 * halo, 16));
+	return std::max<std::ptrdiff_t>(bands, 1);
+};
+
+inline auto for_each_band = [](auto threads, auto process, auto heights, auto halo, auto body) {
+	auto tasks = std::vector<std::array<std::ptrdiff_t, 3>>{};
+	for (auto plane : Range{ process.size() })
+		if (process[plane] && heights[plane] > 0) {
+			auto bands = split_rows(threads, heights[plane], halo[plane]);
+			for (auto band : Range{ bands })
+				tasks.push_back({ plane, band * heights[plane] / bands, (band + 1) * heights[plane] / bands });
+		}
+		else
+			continue;
+	auto run = [&](auto i) { body(tasks[i][0], tasks[i][1], tasks[i][2]); };
+	if (threads > 1)
+		ThreadPool::Instance().Run(threads, tasks.size(), run);
+	else
+		for (auto i : Range{ tasks.size() })
+			run(i);
+};
+
+inline auto sobel_plane = [](auto& kernels, auto srcp8, auto dstp8, auto src_stride, auto dst_stride, auto width, auto height, auto first, auto last, auto thresh, auto& source, auto& samples, auto scratch) {
+	auto sobel = [&](auto sobel_row, auto srcp) {
+		src_stride /= sizeof(*srcp);
+		for (auto y : Range{ first, last }) {
+			auto center = std::clamp<std::ptrdiff_t>(y, 1, height - 2);
+			auto dstp = dstp8 + y * dst_stride;
+			auto row = samples.Target(dstp, scratch);
+			sobel_row(srcp + (center - 1) * src_stride, srcp + center * src_stride, srcp + (center + 1) * src_stride, row, width, thresh, source.peak);
+			samples.Narrow(kernels, row, width, dstp);
+		}
+	};
+	if (source.storage == Storage::Byte)
+		sobel(kernels.sobel_byte, srcp8);
+	else if (source.storage == Storage::Word)
+		sobel(kernels.sobel_word, reinterpret_cast<const std::uint16_t*>(srcp8));
+	else
+		sobel(kernels.sobel_row, reinterpret_cast<const float*>(srcp8));
+};
+
+// mask rows clamped to the plane, as floats. converted masks are widened into a ring of 3 scratch rows, so walking
+// down the plane widens each row once.
+inline auto mask_rows = [](auto& kernels, auto& samples, auto edgep8, auto edge_stride, auto mask_width, auto mask_height, auto scratch, auto row_stride) {
+	return [&kernels, &samples, edgep8, edge_stride, mask_width, mask_height, scratch, row_stride, widened = std::array{ -1_ptrdiff, -1_ptrdiff, -1_ptrdiff }](auto row) mutable {
+		row = clamp_row(row, mask_height);
+		if (samples.Converted() == false)
+			return reinterpret_cast<const float*>(edgep8 + row * edge_stride);
+		if (auto& cached = widened[row % 3]; cached != row) {
+			samples.Widen(kernels, edgep8 + row * edge_stride, mask_width, scratch + row % 3 * row_stride);
+			cached = row;
+		}
+		return static_cast<const float*>(scratch + row % 3 * row_stride);
+	};
+};
+
+// ssw and ssh are the subsampling of the plane against the mask, nonzero only for chroma warped along a luma mask.
+inline auto warp_plane = [](auto& kernels, auto srcp8, auto edgep8, auto dstp8, auto src_stride, auto edge_stride, auto dst_stride, auto width, auto height, auto first, auto last, auto depth, auto SMAGL, auto ssw, auto ssh, auto& source, auto& samples, auto scratch, auto row_stride) {
+	auto edge_row = mask_rows(kernels, samples, edgep8, edge_stride, width << ssw, height << ssh, scratch, row_stride);
+	auto warp = [&](auto warp_row, auto srcp, auto dstp) {
+		src_stride /= sizeof(*srcp);
+		dst_stride /= sizeof(*dstp);
+		for (auto y : Range{ first, last })
+			warp_row(srcp + (y << SMAGL) * src_stride, edge_row((y << ssh) - 1), edge_row(y << ssh), edge_row((y << ssh) + 1), dstp + y * dst_stride, src_stride, width, y, height, depth, SMAGL, ssw, ssh);
+	};
+	if (source.storage == Storage::Byte)
+		warp(kernels.warp_byte, srcp8, dstp8);
+	else if (source.storage == Storage::Word)
+		warp(kernels.warp_word, reinterpret_cast<const std::uint16_t*>(srcp8), reinterpret_cast<std::uint16_t*>(dstp8));
+	else
+		warp(kernels.warp_row, reinterpret_cast<const float*>(srcp8), reinterpret_cast<float*>(dstp8));
+};
+
+struct WarpTarget final {
+	self(srcp8, static_cast<const std::uint8_t*>(nullptr));
+	self(dstp8, static_cast<std::uint8_t*>(nullptr));
+	self(src_stride, 0_ptrdiff);
+	self(dst_stride, 0_ptrdiff);
+	self(width, 0);
+	self(height, 0);
+	self(depth, 0ll);
+	self(ssw, 0);
+	self(ssh, 0);
+};
+
+// the scaled gradients of each mask row in [first, last), computed into a ring of slots pairs of scratch rows after the
+// mask ring and handed to emit(gradient_h, gradient_v, row). they stay valid until slots more rows have been emitted.
+inline auto gradient_rows = [](auto& kernels, auto& samples, auto edgep8, auto edge_stride, auto mask_width, auto mask_height, auto first, auto last, auto scratch, auto row_stride, auto slots, auto emit) {
+	auto edge_row = mask_rows(kernels, samples, edgep8, edge_stride, mask_width, mask_height, scratch, row_stride);
+	for (auto row : Range{ first, last }) {
+		auto gradient_h = reinterpret_cast<int*>(scratch + (3 + 2 * (row % slots)) * row_stride);
+		auto gradient_v = gradient_h + row_stride;
+		kernels.gradient_row(edge_row(row - 1), edge_row(row), edge_row(row + 1), gradient_h, gradient_v, mask_width);
+		emit(static_cast<const int*>(gradient_h), static_cast<const int*>(gradient_v), row);
+	}
+};
+
+// samples [first_x, last_x) of row y of a target plane, displaced by scaled gradients that warp_samples turns into
+// depth and subsampling. with subpixel taps the plane is sampled as its own 4x upscale instead.
+inline auto warp_target_row = [](auto& kernels, auto& source, auto& target, auto gradient_h, auto gradient_v, auto y, auto first_x, auto last_x, auto depth, auto SMAGL, auto ssw, auto ssh, auto taps) {
+	auto warp = [&](auto warp_gradient_row, auto warp_resampled_row, auto srcp, auto dstp) {
+		auto src_stride = static_cast<int>(target.src_stride / static_cast<std::ptrdiff_t>(sizeof(*srcp)));
+		auto dst_stride = target.dst_stride / static_cast<std::ptrdiff_t>(sizeof(*dstp));
+		if (taps != 0)
+			warp_resampled_row(srcp, gradient_h, gradient_v, dstp + y * dst_stride, src_stride, target.width, first_x, last_x, y, target.height, depth, ssw, ssh, taps, source.peak);
+		else
+			warp_gradient_row(srcp + (y << SMAGL) * src_stride, gradient_h, gradient_v, dstp + y * dst_stride, src_stride, target.width, first_x, last_x, y, target.height, depth, SMAGL, ssw, ssh);
+	};
+	if (source.storage == Storage::Byte)
+		warp(kernels.warp_gradient_byte, kernels.warp_resampled_byte, target.srcp8, target.dstp8);
+	else if (source.storage == Storage::Word)
+		warp(kernels.warp_gradient_word, kernels.warp_resampled_word, reinterpret_cast<const std::uint16_t*>(target.srcp8), reinterpret_cast<std::uint16_t*>(target.dstp8));
+	else
+		warp(kernels.warp_gradient_row, kernels.warp_resampled_row, reinterpret_cast<const float*>(target.srcp8), reinterpret_cast<float*>(target.dstp8));
+};
+
+// a target sample whose scaled gradients are zero is not displaced, and away from the last row, where the vertical
+// clamp pulls in 1/128 of the row above, that makes it the co-sited source sample. the gradient rows are checked in
+// tiles of activity_tile_width mask columns, and quiet tiles, flat or all-zero mask, are copied instead of warped.
+constexpr auto activity_tile_width = 64;
+
+inline auto activity_tiles = [](auto width) {
+	return (width + activity_tile_width - 1) / activity_tile_width;
+};
+
+// whether every byte of a range is zero, by comparing it with itself one byte further on, which the C library does a
+// vector at a time.
+inline auto all_zero = [](const void* p, std::size_t bytes) {
+	auto bytep = static_cast<const std::uint8_t*>(p);
+	return bytes == 0 || (bytep[0] == 0 && std::memcmp(bytep, bytep + 1, bytes - 1) == 0);
+};
+
+inline auto gradient_activity = [](auto gradient_h, auto gradient_v, auto width, auto active) {
+	for (auto tile : Range{ activity_tiles(width) }) {
+		auto first = tile * activity_tile_width;
+		auto bytes = (std::min<std::ptrdiff_t>(first + activity_tile_width, width) - first) * sizeof(int);
+		active[tile] = all_zero(gradient_h + first, bytes) == false || all_zero(gradient_v + first, bytes) == false;
+	}
+};
+
+// calls warp(first, last) for each run of active tiles and copy(first, last) for each run of quiet ones in the mask
+// columns [first, last).
+inline auto for_each_activity_run = [](auto active, std::ptrdiff_t first, std::ptrdiff_t last, auto warp, auto copy) {
+	while (first < last) {
+		auto run_last = first;
+		auto state = active[first / activity_tile_width];
+		do
+			run_last = std::min(run_last / activity_tile_width * activity_tile_width + activity_tile_width, last);
+		while (run_last < last && active[run_last / activity_tile_width] == state);
+		if (state)
+			warp(first, run_last);
+		else
+			copy(first, run_last);
+		first = run_last;
+	}
+};
+
+inline auto copy_target_row = [](auto& source, auto& target, auto y, auto first_x, auto last_x, auto SMAGL) {
+	auto copy = [&](auto srcp, auto dstp) {
+		srcp += (y << SMAGL) * (target.src_stride / static_cast<std::ptrdiff_t>(sizeof(*srcp)));
+		dstp += y * (target.dst_stride / static_cast<std::ptrdiff_t>(sizeof(*dstp)));
+		if (SMAGL == 0)
+			std::memcpy(dstp + first_x, srcp + first_x, (last_x - first_x) * sizeof(*srcp));
+		else for (auto x : Range{ first_x, last_x, 1 })
+			dstp[x] = srcp[x << SMAGL];
+	};
+	if (source.storage == Storage::Byte)
+		copy(target.srcp8, target.dstp8);
+	else if (source.storage == Storage::Word)
+		copy(reinterpret_cast<const std::uint16_t*>(target.srcp8), reinterpret_cast<std::uint16_t*>(target.dstp8));
+	else
+		copy(reinterpret_cast<const float*>(target.srcp8), reinterpret_cast<float*>(target.dstp8));
+};
+
+// when the source rows that a full output row and its neighbours read, assuming displacements of up to 4 rows, do
+// not fit in cache_bytes (L2 for AWarp, a 4x or 8x source from about 2160p or 1080p up), the output is warped in blocks of warp_block_rows
+// mask rows, and each block in strips of columns narrow enough that the source rows a strip reads for the whole block
+// fit instead. walking such a plane row by row would bring every source line in from memory again for each output row
+// that reaches it.
+constexpr auto warp_block_rows = 16;
+
+inline auto warp_strip_width = [](auto width, auto sample_size, auto source_shift, auto cache_bytes) {
+	auto column_bytes = [&](auto rows) { return static_cast<std::ptrdiff_t>(sample_size) * (rows << source_shift) << source_shift; };
+	auto budget = static_cast<std::ptrdiff_t>(cache_bytes);
+	if (column_bytes(9) * width <= budget)
+		return static_cast<int>(width);
+	return static_cast<int>(std::max(budget / column_bytes(warp_block_rows + 8) / 64 * 64, 64_ptrdiff));
+};
+
+// 3 mask rows, a pair of gradient rows per slot, one row for the activity of every slot, and 3 more pairs to upsample
+// the gradients of a smaller mask.
+inline auto warp_scratch_rows = []() {
+	return 3 + 2 * warp_block_rows + 1 + 6;
+};
+
+// gradient_rows for planes 1 << mask_shift times the size of the mask, emitting rows in [first, last) of the plane.
+// the gradient rows of the 2 mask rows around each plane row are kept in the first 2 pairs after the activity row and
+// upsample_gradient_row interpolates them into the slot through the third.
+inline auto upsampled_gradient_rows = [](auto& kernels, auto& samples, auto edgep8, auto edge_stride, auto mask_width, auto mask_height, auto mask_shift, auto first, auto last, auto scratch, auto row_stride, auto slots, auto emit) {
+	if (mask_shift == 0)
+		return gradient_rows(kernels, samples, edgep8, edge_stride, mask_width, mask_height, first, last, scratch, row_stride, slots, emit);
+	auto edge_row = mask_rows(kernels, samples, edgep8, edge_stride, mask_width, mask_height, scratch, row_stride);
+	auto pairs = scratch + (4 + 2 * warp_block_rows) * row_stride;
+	auto computed = std::array{ -1_ptrdiff, -1_ptrdiff };
+	auto mask_gradients = [&](auto row) {
+		row = clamp_row(row, mask_height);
+		auto gradient_h = reinterpret_cast<int*>(pairs + 2 * (row % 2) * row_stride);
+		auto gradient_v = gradient_h + row_stride;
+		if (computed[row % 2] != row) {
+			kernels.gradient_row(edge_row(row - 1), edge_row(row), edge_row(row + 1), gradient_h, gradient_v, mask_width);
+			computed[row % 2] = row;
+		}
+		return std::array{ static_cast<const int*>(gradient_h), static_cast<const int*>(gradient_v) };
+	};
+	auto blended_h = reinterpret_cast<int*>(pairs + 4 * row_stride);
+	auto blended_v = blended_h + row_stride;
+	for (auto row : Range{ first, last }) {
+		auto position = 2 * row + 1 - (1 << mask_shift);
+		auto above = position >> (mask_shift + 1);
+		auto [above_h, above_v] = mask_gradients(above);
+		auto [below_h, below_v] = mask_gradients(above + 1);
+		auto gradient_h = reinterpret_cast<int*>(scratch + (3 + 2 * (row % slots)) * row_stride);
+		auto gradient_v = gradient_h + row_stride;
+		kernels.upsample_gradient_row(above_h, above_v, below_h, below_v, static_cast<int>(position & ((2 << mask_shift) - 1)), blended_h, blended_v, gradient_h, gradient_v,
+			static_cast<int>(mask_width), static_cast<int>(mask_width << mask_shift), mask_shift);
+		emit(static_cast<const int*>(gradient_h), static_cast<const int*>(gradient_v), row);
+	}
+};
+
+// the scaled gradients of each mask row are computed once and displace the co-sited row of every target plane, which
+// only differ in depth and subsampling: all planes along a luma mask with chroma=0, one plane along its own mask
+// otherwise, of every clip warped along the mask. targets without a source are not processed. the gradients of a
+// block stay in scratch until every strip has been warped. quiet tiles, and every tile of a target with depth=0, are
+// copied, except with subpixel taps, where no displacement still resamples the plane. when every target has depth=0
+// no row depends on the mask, which is not read at all: zero gradients stand in for it, and the rows that are still
+// warped, the last and all of them with taps, get the samples any gradients would give.
+// a mask 1 << mask_shift times smaller than the planes has its gradients upsampled first, and first and last, like
+// everything else past this point, count rows of the upsampled gradients.
+inline auto warp_targets = [](auto& kernels, auto& targets, auto edgep8, auto edge_stride, auto mask_width, auto mask_height, auto mask_shift, auto first, auto last, auto SMAGL, auto taps, auto& source, auto& samples, auto scratch, auto row_stride, auto cache_bytes) {
+	auto width = mask_width << mask_shift;
+	auto sample_size = source.storage == Storage::Byte ? 1 : source.storage == Storage::Word ? 2 : 4;
+	auto source_shift = taps != 0 ? 0 : SMAGL;
+	auto strip_width = warp_strip_width(width, sample_size, source_shift, cache_bytes);
+	auto slots = strip_width < width ? warp_block_rows : 1;
+	auto gradients = std::array<std::array<const int*, 2>, warp_block_rows>{};
+	auto activity = reinterpret_cast<std::uint8_t*>(scratch + (3 + 2 * warp_block_rows) * row_stride);
+	auto tiles = activity_tiles(width);
+	auto warp_block = [&](auto block_first, auto block_last) {
+		for (auto strip : Range{ 0, width, strip_width })
+			for (auto row : Range{ block_first, block_last, 1 })
+				for (auto& target : targets)
+					if (auto y = static_cast<int>(row >> target.ssh); target.srcp8 != nullptr && (y << target.ssh) == row) {
+						auto [gradient_h, gradient_v] = gradients[row % slots];
+						auto columns = [&](auto first, auto last) {
+							return std::array{ static_cast<int>(first >> target.ssw), static_cast<int>(std::min(last >> target.ssw, static_cast<std::ptrdiff_t>(target.width))) };
+						};
+						auto warp = [&](auto first, auto last) {
+							auto [first_x, last_x] = columns(first, last);
+							warp_target_row(kernels, source, target, gradient_h, gradient_v, y, first_x, last_x, target.depth, SMAGL, target.ssw, target.ssh, taps);
+						};
+						auto strip_last = std::min<std::ptrdiff_t>(strip + strip_width, width);
+						auto copy = [&](auto first, auto last) {
+							auto [first_x, last_x] = columns(first, last);
+							copy_target_row(source, target, y, first_x, last_x, SMAGL);
+						};
+						if (taps != 0 || y + 1 == target.height)
+							warp(strip, strip_last);
+						else if (target.depth == 0)
+							copy(strip, strip_last);
+						else for_each_activity_run(activity + row % slots * tiles, strip, strip_last, warp, copy);
+					}
+	};
+	auto block_first = first;
+	auto still = std::all_of(targets.begin(), targets.end(), [](auto& target) { return target.srcp8 == nullptr || target.depth == 0; });
+	auto emit = [&](auto gradient_h, auto gradient_v, auto row) {
+		gradients[row % slots] = { gradient_h, gradient_v };
+		if (taps == 0 && still == false)
+			gradient_activity(gradient_h, gradient_v, width, activity + row % slots * tiles);
+		if (row + 1 == last || (row + 1) % slots == 0) {
+			warp_block(block_first, row + 1);
+			block_first = row + 1;
+		}
+	};
+	if (still) {
+		auto zero = reinterpret_cast<int*>(scratch + 3 * row_stride);
+		std::fill_n(zero, 2 * row_stride, 0);
+		for (auto row : Range{ first, last, 1 })
+			emit(static_cast<const int*>(zero), static_cast<const int*>(zero + row_stride), row);
+	}
+	else
+		upsampled_gradient_rows(kernels, samples, edgep8, edge_stride, mask_width, mask_height, mask_shift, first, last, scratch, row_stride, slots, emit);
+};
+
+// a displacement clip stores each row of a plane as 2 rows of 16-bit integers, the horizontal and then the vertical
+// displacement in 1/128 samples, with depth and subsampling already applied. a mask in [0, 1] has gradients of at most
+// 256 and depth is at most 128 in magnitude, so the displacement stays within 16384 and is stored exactly; larger ones
+// saturate at 256 samples. the rows are widened into scratch, and warping by them as gradients with depth 2 reproduces
+// AWarp with the mask they were made from.
+inline auto narrow_displacement = [](auto displacement, auto fieldp, auto width) {
+	for (auto x : Range{ width })
+		fieldp[x] = static_cast<std::int16_t>(std::clamp(displacement[x], -32768, 32767));
+};
+
+inline auto warp_displaced = [](auto& kernels, auto& target, auto fieldp8, auto field_stride, auto first, auto last, auto SMAGL, auto taps, auto& source, auto scratch, auto row_stride) {
+	auto displacement_h = reinterpret_cast<int*>(scratch);
+	auto displacement_v = displacement_h + row_stride;
+	for (auto y : Range{ first, last }) {
+		auto field_h = reinterpret_cast<const std::int16_t*>(fieldp8 + 2 * y * field_stride);
+		auto field_v = reinterpret_cast<const std::int16_t*>(fieldp8 + (2 * y + 1) * field_stride);
+		for (auto x : Range{ target.width }) {
+			displacement_h[x] = field_h[x];
+			displacement_v[x] = field_v[x];
+		}
+		warp_target_row(kernels, source, target, static_cast<const int*>(displacement_h), static_cast<const int*>(displacement_v), static_cast<int>(y), 0, target.width, 2ll, SMAGL, 0, 0, taps);
+	}
+};
+
+inline auto scratch_stride = [](auto width) {
+	return (width + 15) / 16 * 16;
+};
+
+inline auto blur_stream_rows = [](auto& kernels, auto blur_level) {
+	return blur_level * (2 * kernels.blur_radius + 1) + 1;
+};
+
+inline auto blur_stream = [](auto& kernels, auto width, auto height, auto first, auto last, auto blur_level, auto buffer, auto row_stride, auto input_row, auto output_row, auto emit) {
+	auto radius = kernels.blur_radius;
+	auto ring_size = 2 * radius + 1;
+	auto begin = [&](auto level) { return std::max<std::ptrdiff_t>(first - (blur_level - level) * radius, 0); };
+	auto end = [&](auto level) { return std::min<std::ptrdiff_t>(last + (blur_level - level) * radius, height); };
+	auto blurred_row = [&](auto level, auto y) { return buffer + ((level - 1) * ring_size + y % ring_size) * row_stride; };
+	auto scratch = buffer + blur_level * ring_size * row_stride;
+	auto rows = std::vector<const float*>(ring_size);
+	auto produced = std::vector<std::ptrdiff_t>(blur_level + 1);
+	for (auto level : Range{ blur_level + 1 })
+		produced[level] = begin(level);
+	auto forward = [&](auto& ycomb, auto level, auto y) -> void {
+		for (auto next = produced[level]; next < end(level) && y >= std::min<std::ptrdiff_t>(next + radius, height - 1); next = ++produced[level]) {
+			for (auto i : Range{ ring_size })
+				rows[i] = blurred_row(level, clamp_row(next + i - radius, height));
+			if (level < blur_level) {
+				kernels.blur_vertical(rows.data(), scratch, width, next, height);
+				kernels.blur_horizontal(scratch, blurred_row(level + 1, next), width);
+				ycomb(ycomb, level + 1, next);
+			}
+			else {
+				kernels.blur_vertical(rows.data(), output_row(next), width, next, height);
+				emit(next);
+			}
+		}
+	};
+	for (auto y : Range{ begin(0), end(0) })
+		if (blur_level > 0) {
+			kernels.blur_horizontal(input_row(y, scratch), blurred_row(1, y), width);
+			forward(forward, 1ll, y);
+		}
+		else {
+			auto dstp = output_row(y);
+			if (auto srcp = input_row(y, dstp); srcp != dstp)
+				std::memcpy(dstp, srcp, width * sizeof(float));
+			emit(y);
+		}
+};
+
+// every pass of a blur keeps a row at zero if all rows within reach of it are zero, as in the letterbox bars and flat
+// fills of an edge mask. ABlur clears such rows in blocks of activity_block_rows and blurs the runs between them. rows
+// are checked bit for bit, so a negative zero keeps its neighbourhood blurred.
+constexpr auto activity_block_rows = 16;
+
+inline auto sharpen_buffer_rows = [](auto& kernels, auto blur_level) {
+	return blur_stream_rows(kernels, blur_level) + 3;
+};
+
+inline auto sharpen_plane = [](auto& kernels, auto srcp8, auto stride, auto width, auto height, auto first, auto last, auto thresh, auto blur_level, auto buffer, auto row_stride, auto warp_rows) {
+	auto srcp = reinterpret_cast<const float*>(srcp8);
+	auto mask_row = [&](auto y) { return buffer + y % 3 * row_stride; };
+	auto warped = static_cast<std::ptrdiff_t>(first);
+	stride /= sizeof(float);
+	blur_stream(kernels, width, height, clamp_row(first - 1, height), std::min<std::ptrdiff_t>(last + 1, height), blur_level, buffer + 3 * row_stride, row_stride,
+		[&](auto y, auto dstp) {
+			auto center = std::clamp<std::ptrdiff_t>(y, 1, height - 2);
+			kernels.sobel_row(srcp + (center - 1) * stride, srcp + center * stride, srcp + (center + 1) * stride, dstp, width, thresh, 1.);
+			return static_cast<const float*>(dstp);
+		},
+		mask_row,
+		[&](auto y) {
+			for (; warped < last && y >= std::min<std::ptrdiff_t>(warped + 1, height - 1); ++warped)
+				warp_rows(warped, mask_row(clamp_row(warped - 1, height)), mask_row(warped), mask_row(clamp_row(warped + 1, height)));
+		});
+};
+
+// the embeddable entry points. each runs one filter of the plugin over a frame of up to 3 planes in buffers the
+// caller owns, read and written in place through their strides, and gives the output of the plugin bit for bit: the
+// plugin only wraps its frames in spans and calls them.
+
+// a plane of width x height samples, row y starting y * stride bytes after data.
+template<typename Byte>
+struct PlaneSpan final {
+	self(data, static_cast<Byte*>(nullptr));
+	self(stride, 0_ptrdiff);
+	self(width, 0);
+	self(height, 0);
+	auto Row(std::ptrdiff_t y) const {
+		return data + y * stride;
+	}
+};
+
+// the planes of a frame in one storage, with chroma planes 1 << ssw times narrower and 1 << ssh times shorter than
+// luma. a plane without data is neither read nor written, but its size still counts where it is given.
+template<typename Byte>
+struct FrameSpan final {
+	self(planes, (std::array<PlaneSpan<Byte>, 3>{}));
+	self(samples, PlaneSamples{});
+	self(ssw, 0);
+	self(ssh, 0);
+	auto& operator[](std::ptrdiff_t plane) const {
+		return planes[plane];
+	}
+	auto Heights() const {
+		return std::array{ planes[0].height, planes[1].height, planes[2].height };
+	}
+};
+
+using SourceFrame = FrameSpan<const std::uint8_t>;
+using TargetFrame = FrameSpan<std::uint8_t>;
+
+// how an entry point runs: the kernel sets and strip budget of tuning, or the double precision reference when single
+// is false, up to threads threads, and scratch blocks from arena, ScratchArena::Shared() for one arena shared with
+// every other user in the process. without an arena each call makes one of its own.
+struct CoreOptions final {
+	self(tuning, (Tuning{ SupportedISA(), SupportedISA(), SupportedISA(), L2CacheBytes() }));
+	self(threads, 1ll);
+	self(single, true);
+	self(arena, static_cast<ScratchArena*>(nullptr));
+};
+
+// scratch blocks of floats floats for one call, from the arena of options or from local.
+inline auto call_arena = [](auto options, auto floats, auto& local) {
+	auto arena = options.arena;
+	if (arena == nullptr)
+		arena = (local = std::make_unique<ScratchArena>()).get();
+	return [arena, floats = static_cast<std::size_t>(floats)] { return arena->Acquire(floats); };
+};
+
+inline auto sobel_scratch_floats = [](auto width) {
+	return scratch_stride(width);
+};
+
+inline auto blur_scratch_floats = [](auto blur_type, auto blur_level, auto width) {
+	auto kernels = select_kernels(ISA::None, blur_type, false);
+	return (blur_stream_rows(kernels, blur_level) + 1) * scratch_stride(width);
+};
+
+inline auto warp_scratch_floats = [](auto width) {
+	return warp_scratch_rows() * scratch_stride(width);
+};
+
+inline auto displacement_scratch_floats = [](auto width) {
+	return 7 * scratch_stride(width);
+};
+
+inline auto sharpen_scratch_floats = [](auto blur_type, auto blur_level, auto width) {
+	auto kernels = select_kernels(ISA::None, blur_type, false);
+	return (sharpen_buffer_rows(kernels, blur_level) + 3) * scratch_stride(width);
+};
+
+// ASobel: the edge mask of each plane in process, stored as dst stores its samples. the other planes of dst with data
+// get the samples of src in that storage.
+inline auto sobel_frame = [](auto options, auto src, auto dst, auto process, auto thresh) {
+	auto local = std::unique_ptr<ScratchArena>{};
+	auto acquire = call_arena(options, sobel_scratch_floats(src[0].width), local);
+	auto kernels = select_tuned_kernels(options.tuning, 0ll, options.single);
+	auto written = std::array{ dst[0].data != nullptr, dst[1].data != nullptr, dst[2].data != nullptr };
+	for_each_band(options.threads, written, src.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto plane, auto first, auto last) {
+		auto width = src[plane].width;
+		auto scratch = acquire();
+		if (process[plane])
+			sobel_plane(kernels, src[plane].data, dst[plane].data, src[plane].stride, dst[plane].stride, width, src[plane].height, first, last, thresh, src.samples, dst.samples, scratch.get());
+		else
+			for (auto y : Range{ first, last })
+				dst.samples.Narrow(kernels, src.samples.Widen(kernels, src[plane].Row(y), width, scratch.get()), width, dst[plane].Row(y));
+	});
+};
+
+// ABlur: levels[plane] passes of the blur_type blur over each plane of dst with data, or the collapsed taps of the
+// plane when taps is not null. src and dst share their storage, and planes with no passes are not written.
+inline auto blur_frame = [](auto options, auto src, auto dst, auto blur_type, auto levels, const std::vector<BlurTaps>* taps) {
+	auto deepest = std::max({ levels[0], levels[1], levels[2] });
+	auto local = std::unique_ptr<ScratchArena>{};
+	auto acquire = call_arena(options, blur_scratch_floats(blur_type, deepest, dst[0].width), local);
+	auto blurred = std::array{ dst[0].data != nullptr && levels[0] > 0, dst[1].data != nullptr && levels[1] > 0, dst[2].data != nullptr && levels[2] > 0 };
+	auto kernels = select_tuned_kernels(options.tuning, blur_type, options.single);
+	auto row_stride = scratch_stride(dst[0].width);
+	auto samples = src.samples;
+	auto halo = std::array{ 0ll, 0ll, 0ll };
+	for (auto plane : Range{ 3 })
+		if (blurred[plane])
+			halo[plane] = levels[plane] * kernels.blur_radius;
+	for_each_band(options.threads, blurred, dst.Heights(), halo, [&](auto plane, auto first, auto last) {
+		auto [srcp, dstp] = std::pair{ src[plane].data, dst[plane].data };
+		auto [src_stride, dst_stride] = std::array{ src[plane].stride, dst[plane].stride };
+		auto width = dst[plane].width;
+		auto height = dst[plane].height;
+		auto temp = acquire();
+		auto output = temp.get() + blur_stream_rows(kernels, deepest) * row_stride;
+		auto blur = [&](auto& blur_kernels, auto passes, auto run_first, auto run_last) {
+			blur_stream(blur_kernels, width, height, run_first, run_last, passes, temp.get(), row_stride,
+				[&](auto y, auto scratch) { return samples.Widen(kernels, srcp + y * src_stride, width, scratch); },
+				[&](auto y) { return samples.Target(dstp + y * dst_stride, output); },
+				[&](auto y) { samples.Narrow(kernels, samples.Target(dstp + y * dst_stride, output), width, dstp + y * dst_stride); });
+		};
+		auto blur_rows = [&](auto run_first, auto run_last) {
+			if (run_first >= run_last)
+				return;
+			if (taps != nullptr && std::min(width, height) > 2 * (*taps)[plane].radius) {
+				auto collapsed = CollapsedBlur{ &kernels, &(*taps)[plane], (*taps)[plane].radius };
+				blur(collapsed, 1ll, run_first, run_last);
+			}
+			else
+				blur(kernels, levels[plane], run_first, run_last);
+		};
+		// the double precision reference blurs every row.
+		if (options.single == false) {
+			blur_rows(first, last);
+			return;
+		}
+		auto reach = halo[plane];
+		auto scanned = std::max<std::ptrdiff_t>(first - reach, 0);
+		auto last_active = static_cast<std::ptrdiff_t>(-reach - 1);
+		auto run_first = first;
+		for (auto block_first = first; block_first < last;) {
+			auto block_last = std::min<std::ptrdiff_t>(block_first / activity_block_rows * activity_block_rows + activity_block_rows, last);
+			for (; scanned < std::min<std::ptrdiff_t>(block_last + reach, height); ++scanned)
+				if (all_zero(srcp + scanned * src_stride, static_cast<std::size_t>(width) * samples.SampleBytes()) == false)
+					last_active = scanned;
+			if (last_active < block_first - reach) {
+				blur_rows(run_first, block_first);
+				for (auto y : Range{ block_first, block_last })
+					std::memset(dstp + y * dst_stride, 0, static_cast<std::size_t>(width) * samples.SampleBytes());
+				run_first = block_last;
+			}
+			block_first = block_last;
+		}
+		blur_rows(run_first, last);
+	});
+};
+
+// AWarp: every frame of srcs warped along mask into the frame of dsts at the same index, the planes of dsts with data
+// only, all of them from the gradients of each mask row worked out once. mask is 1 << mask_shift times smaller than
+// dsts, or with displaced an ADisplacement field of their size, and srcs are the size of dsts or 2, 4 or 8 times it.
+// with along_luma every plane follows luma of the mask, otherwise each plane its own. taps of 1 or 2 sample a same
+// size source as its bilinear or bicubic 4x upscale. when every plane of dsts has depth 0 the mask is not read, and
+// its planes only need their sizes.
+inline auto warp_frames = [](auto options, auto& srcs, auto& dsts, auto mask, auto depth, auto along_luma, auto displaced, auto taps, auto mask_shift) {
+	auto& src = srcs[0];
+	auto& dst = dsts[0];
+	auto warped = std::array{ dst[0].data != nullptr, dst[1].data != nullptr, dst[2].data != nullptr };
+	auto SMAGL = 0;
+	auto mask_width = mask[0].width;
+	auto mask_height = mask[0].height;
+	auto width = mask_width << mask_shift;
+	while (width << SMAGL != src[0].width)
+		++SMAGL;
+	auto local = std::unique_ptr<ScratchArena>{};
+	auto acquire = call_arena(options, warp_scratch_floats(width), local);
+	auto kernels = select_tuned_kernels(options.tuning, 1ll, options.single || ((displaced || mask_shift != 0) && taps == 0));
+	auto source = src.samples;
+	auto samples = mask.samples;
+	auto row_stride = scratch_stride(width);
+	auto edgeps = std::array<const std::uint8_t*, 3>{};
+	for (auto plane : Range{ 3 })
+		if (warped[plane])
+			edgeps[plane] = mask[along_luma ? 0 : plane].data;
+	// the planes of every frame, 3 per frame.
+	auto targets = std::vector<WarpTarget>(3 * srcs.size());
+	for (auto frame : Range{ srcs.size() })
+		for (auto plane : Range{ 3 })
+			if (warped[plane]) {
+				auto [ssw, ssh] = along_luma && plane > 0 ? std::array{ src.ssw, src.ssh } : std::array{ 0, 0 };
+				targets[3 * frame + plane] = { srcs[frame][plane].data, dsts[frame][plane].data, srcs[frame][plane].stride, dsts[frame][plane].stride, dst[plane].width, dst[plane].height, depth[plane], ssw, ssh };
+			}
+	// the strips of each frame share the cache.
+	auto cache_bytes = options.tuning.cache_bytes / srcs.size();
+	if (displaced)
+		for_each_band(options.threads, warped, dst.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto plane, auto first, auto last) {
+			auto scratch = acquire();
+			for (auto frame : Range{ srcs.size() })
+				warp_displaced(kernels, targets[3 * frame + plane], edgeps[plane], mask[plane].stride, first, last, SMAGL, taps, source, scratch.get(), row_stride);
+		});
+	else if (along_luma && (kernels.warp_gradient_row != nullptr || taps != 0))
+		for_each_band(options.threads, std::array{ warped[0] || warped[1] || warped[2], false, false }, dst.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto, auto first, auto last) {
+			auto scratch = acquire();
+			warp_targets(kernels, targets, mask[0].data, mask[0].stride, mask_width, mask_height, mask_shift, first, last, SMAGL, taps, source, samples, scratch.get(), row_stride, cache_bytes);
+		});
+	else if (kernels.warp_gradient_row != nullptr || taps != 0)
+		for_each_band(options.threads, warped, dst.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto plane, auto first, auto last) {
+			auto scratch = acquire();
+			auto plane_targets = std::vector<WarpTarget>{};
+			for (auto frame : Range{ srcs.size() })
+				plane_targets.push_back(targets[3 * frame + plane]);
+			warp_targets(kernels, plane_targets, edgeps[plane], mask[plane].stride, mask[plane].width, mask[plane].height, mask_shift, first, last, SMAGL, taps, source, samples, scratch.get(), row_stride, cache_bytes);
+		});
+	else for_each_band(options.threads, warped, dst.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto plane, auto first, auto last) {
+		auto scratch = acquire();
+		auto edgep = edgeps[plane];
+		auto edge_stride = mask[along_luma ? 0 : plane].stride;
+		auto edge_samples = samples;
+		// a plane with depth=0 reads one row of zeros as every row of its mask.
+		if (depth[plane] == 0) {
+			std::fill_n(scratch.get() + 3 * row_stride, row_stride, 0.f);
+			edgep = reinterpret_cast<const std::uint8_t*>(scratch.get() + 3 * row_stride);
+			edge_stride = 0;
+			edge_samples = PlaneSamples{};
+		}
+		for (auto frame : Range{ srcs.size() }) {
+			auto& target = targets[3 * frame + plane];
+			warp_plane(kernels, target.srcp8, edgep, target.dstp8, target.src_stride, edge_stride, target.dst_stride,
+				target.width, target.height, first, last, target.depth, SMAGL, target.ssw, target.ssh, source, edge_samples, scratch.get(), row_stride);
+		}
+	});
+};
+
+// ADisplacement: the displacement AWarp would apply along mask with depth, into the planes of field that have data,
+// twice as tall as the mask and holding 16-bit integers.
+inline auto displacement_frame = [](auto options, auto mask, auto field, auto depth, auto along_luma) {
+	auto width = mask[0].width;
+	auto local = std::unique_ptr<ScratchArena>{};
+	auto acquire = call_arena(options, displacement_scratch_floats(width), local);
+	auto kernels = select_tuned_kernels(options.tuning, 1ll, true);
+	auto samples = mask.samples;
+	auto row_stride = scratch_stride(width);
+	auto present = std::array{ field[0].data != nullptr, field[1].data != nullptr, field[2].data != nullptr };
+	auto displace = [&](auto plane, auto gradient_h, auto gradient_v, auto row, auto ssw, auto ssh, auto scratch) {
+		if (auto y = row >> ssh; (y << ssh) == row) {
+			auto displacement_h = reinterpret_cast<int*>(scratch + 5 * row_stride);
+			auto displacement_v = displacement_h + row_stride;
+			kernels.displacement_row(gradient_h, gradient_v, displacement_h, displacement_v, mask[plane].width, depth[plane], ssw, ssh);
+			narrow_displacement(displacement_h, reinterpret_cast<std::int16_t*>(field[plane].Row(2 * y)), mask[plane].width);
+			narrow_displacement(displacement_v, reinterpret_cast<std::int16_t*>(field[plane].Row(2 * y + 1)), mask[plane].width);
+		}
+	};
+	auto halo = std::array{ 0ll, 0ll, 0ll };
+	if (along_luma)
+		for_each_band(options.threads, std::array{ true, false, false }, mask.Heights(), halo, [&](auto, auto first, auto last) {
+			auto scratch = acquire();
+			gradient_rows(kernels, samples, mask[0].data, mask[0].stride, width, mask[0].height, first, last, scratch.get(), row_stride, 1,
+				[&](auto gradient_h, auto gradient_v, auto row) {
+					for (auto plane : Range{ 3 })
+						if (present[plane])
+							displace(plane, gradient_h, gradient_v, row, plane > 0 ? mask.ssw : 0, plane > 0 ? mask.ssh : 0, scratch.get());
+				});
+		});
+	else
+		for_each_band(options.threads, present, mask.Heights(), halo, [&](auto plane, auto first, auto last) {
+			auto scratch = acquire();
+			gradient_rows(kernels, samples, mask[plane].data, mask[plane].stride, mask[plane].width, mask[plane].height, first, last, scratch.get(), row_stride, 1,
+				[&](auto gradient_h, auto gradient_v, auto row) {
+					displace(plane, gradient_h, gradient_v, row, 0, 0, scratch.get());
+				});
+		});
+};
+
+// AWarpSharp: a single precision src warped along its own blurred edge mask, worked out in rolling rows, into the
+// planes of dst with data, along luma's mask for every plane with along_luma.
+inline auto sharpen_frame = [](auto options, auto src, auto dst, auto thresh, auto blur_type, auto blur_level, auto depth, auto along_luma) {
+	auto warped = std::array{ dst[0].data != nullptr, dst[1].data != nullptr, dst[2].data != nullptr };
+	auto width = src[0].width;
+	auto height = src[0].height;
+	auto local = std::unique_ptr<ScratchArena>{};
+	auto acquire = call_arena(options, sharpen_scratch_floats(blur_type, blur_level, width), local);
+	auto kernels = select_tuned_kernels(options.tuning, blur_type, options.single);
+	auto blur_levels = std::array{ blur_level, (blur_level + 1) / 2, (blur_level + 1) / 2 };
+	auto row_stride = scratch_stride(width);
+	// planes with depth=0 do not depend on the mask, so no sobel or blur runs for them.
+	auto moving = std::array{ warped[0] && depth[0] != 0, warped[1] && depth[1] != 0, warped[2] && depth[2] != 0 };
+	auto still = std::array{ warped[0] && depth[0] == 0, warped[1] && depth[1] == 0, warped[2] && depth[2] == 0 };
+	auto srcps = std::array<const float*, 3>{};
+	auto dstps = std::array<float*, 3>{};
+	auto src_strides = std::array{ 0_ptrdiff, 0_ptrdiff, 0_ptrdiff };
+	auto dst_strides = std::array{ 0_ptrdiff, 0_ptrdiff, 0_ptrdiff };
+	for (auto plane : Range{ 3 }) {
+		srcps[plane] = reinterpret_cast<const float*>(src[plane].data);
+		dstps[plane] = reinterpret_cast<float*>(dst[plane].data);
+		src_strides[plane] = src[plane].stride / static_cast<std::ptrdiff_t>(sizeof(float));
+		dst_strides[plane] = dst[plane].stride / static_cast<std::ptrdiff_t>(sizeof(float));
+	}
+	auto sharpen = [&](auto mask_plane, auto first_plane, auto last_plane, auto first, auto last) {
+		auto buffer = acquire();
+		sharpen_plane(kernels, srcps[mask_plane], src[mask_plane].stride, width, height, first, last, thresh, blur_levels[mask_plane], buffer.get(), row_stride,
+			[&](auto y, auto above, auto center, auto below) {
+				if (kernels.warp_gradient_row != nullptr) {
+					auto gradient_h = reinterpret_cast<int*>(buffer.get() + sharpen_buffer_rows(kernels, blur_level) * row_stride);
+					auto gradient_v = gradient_h + row_stride;
+					auto active = reinterpret_cast<std::uint8_t*>(gradient_v + row_stride);
+					kernels.gradient_row(above, center, below, gradient_h, gradient_v, width);
+					gradient_activity(gradient_h, gradient_v, width, active);
+					for (auto plane : Range{ first_plane, last_plane })
+						if (moving[plane]) {
+							auto srcp = srcps[plane] + y * src_strides[plane];
+							auto dstp = dstps[plane] + y * dst_strides[plane];
+							auto warp = [&](auto first, auto last) {
+								kernels.warp_gradient_row(srcp, gradient_h, gradient_v, dstp, static_cast<int>(src_strides[plane]), width, static_cast<int>(first), static_cast<int>(last), y, height, depth[plane], 0, 0, 0);
+							};
+							if (y + 1 == height)
+								warp(0, width);
+							else
+								for_each_activity_run(active, 0, width, warp, [&](auto first, auto last) { std::memcpy(dstp + first, srcp + first, (last - first) * sizeof(float)); });
+						}
+				}
+				else for (auto plane : Range{ first_plane, last_plane })
+					if (moving[plane])
+						kernels.warp_row(srcps[plane] + y * src_strides[plane], above, center, below, dstps[plane] + y * dst_strides[plane], static_cast<int>(src_strides[plane]), width, y, height, depth[plane], 0, 0, 0);
+			});
+	};
+	auto halo = std::array{ 0ll, 0ll, 0ll };
+	for (auto plane : Range{ 3 })
+		halo[plane] = blur_levels[plane] * kernels.blur_radius + 1;
+	if (along_luma)
+		for_each_band(options.threads, std::array{ moving[0] || moving[1] || moving[2], false, false }, src.Heights(), halo, [&](auto, auto first, auto last) {
+			sharpen(0, 0, 3, first, last);
+		});
+	else
+		for_each_band(options.threads, moving, src.Heights(), halo, [&](auto plane, auto first, auto last) {
+			sharpen(plane, plane, plane + 1, first, last);
+		});
+	// their rows are the source rows, but for the last, which the warp still blends with the row above and which is
+	// warped with zero gradients.
+	for_each_band(options.threads, still, src.Heights(), std::array{ 0ll, 0ll, 0ll }, [&](auto plane, auto first, auto last) {
+		for (auto y : Range{ first, std::min<std::ptrdiff_t>(last, height - 1), 1 })
+			std::memcpy(dstps[plane] + y * dst_strides[plane], srcps[plane] + y * src_strides[plane], width * sizeof(float));
+		if (last == height) {
+			auto scratch = acquire();
+			auto zero = scratch.get();
+			std::fill_n(zero, 2 * row_stride, 0.f);
+			auto y = height - 1;
+			auto srcp = srcps[plane] + y * src_strides[plane];
+			auto dstp = dstps[plane] + y * dst_strides[plane];
+			if (kernels.warp_gradient_row != nullptr)
+				kernels.warp_gradient_row(srcp, reinterpret_cast<const int*>(zero), reinterpret_cast<const int*>(zero + row_stride), dstp, static_cast<int>(src_strides[plane]), width, 0, width, y, height, 0ll, 0, 0, 0);
+			else
+				kernels.warp_row(srcp, zero, zero, zero, dstp, static_cast<int>(src_strides[plane]), width, y, height, 0ll, 0, 0, 0);
+		}
+	});
+};
+
+// the samples and chroma subsampling of a clip, which with the size of its frames is all opt=-1 needs to know of it.
+struct ClipFormat final {
+	self(samples, PlaneSamples{});
+	self(ssw, 0);
+	self(ssh, 0);
+	auto Key() const {
+		return "format " + std::to_string(static_cast<int>(samples.storage)) + " " + std::to_string(static_cast<int>(samples.peak)) + " " + std::to_string(ssw) + " " + std::to_string(ssh);
+	}
+};
+
+// the filters of the plugin, for the stages tune_kernels times.
+enum class Filter {
+	ASobel,
+	ABlur,
+	AWarp,
+	AWarpSharp,
+	ADisplacement
+};
+
+// opt=-1: the kernel families of the stages filter runs are timed on each instruction set the CPU supports, on
+// synthetic rows of width, the width of its output, in the samples of its input and output, and the fastest is kept
+// in tuning, for AWarp along a mask together with the fastest of a few cache budgets around the L2 size that give
+// different strips. input is the format of the clip the filter reads, the mask for AWarp, and output that of the
+// frames it makes. SMAGL is log2 of how many times wider than the output the source of AWarp is, and taps and
+// displaced are its subpixel and whether it warps along an ADisplacement field. the choices are keyed by family,
+// frame size and the formats in TuningCache, so each is timed once per CPU. the families tuned are returned with the
+// tuning for the log, the others keep their choice in tuning.
+inline auto tune_kernels = [](auto tuning, auto filter, auto width, auto height, auto input, auto output, auto blur_type, auto blur_level, auto SMAGL, auto taps, auto displaced) {
+	auto tuned = ""s;
+	auto candidates = std::vector<ISA>{ ISA::None };
+	for (auto isa : { ISA::SSE2, ISA::AVX2, ISA::AVX512 })
+		if (isa <= SupportedISA())
+			candidates.push_back(isa);
+	auto fastest = [&](auto run) {
+		auto [best, choice] = std::pair{ 1e300, ISA::None };
+		for (auto isa : candidates)
+			if (auto seconds = BestTime([&] { run(isa); }); seconds < best)
+				std::tie(best, choice) = std::pair{ seconds, isa };
+		return choice;
+	};
+	// values in [0, scale] in the storage of samples, in a buffer of floats that holds the plane in any storage.
+	auto plane = [](auto width, auto height, auto scale, auto samples) {
+		auto values = std::vector<float>(scratch_stride(width) * height);
+		for (auto i : Range{ values.size() })
+			values[i] = scale * static_cast<float>((static_cast<std::uint32_t>(i) * 2654435761u) >> 16) / 65535.f;
+		auto stored = std::vector<float>(values.size());
+		samples.Narrow(select_kernels(ISA::None, 1ll, true), values.data(), static_cast<int>(values.size()), reinterpret_cast<std::uint8_t*>(stored.data()));
+		return stored;
+	};
+	auto bytes = [](auto& samples) { return reinterpret_cast<std::uint8_t*>(samples.data()); };
+	auto name = [](auto isa) { return std::array{ "scalar", "sse2", "avx2", "avx512" }[static_cast<int>(isa)]; };
+	auto stride = scratch_stride(width);
+	auto geometry = std::to_string(width) + "x" + std::to_string(height) + " " + input.Key() + " to " + output.Key();
+	auto& cache = TuningCache::Instance();
+	if (filter == Filter::ASobel || filter == Filter::AWarpSharp) {
+		tuning.sobel = cache.Lookup("sobel " + geometry, [&] {
+			auto [source, storage] = std::array{ input.samples, output.samples };
+			auto [src, dst, scratch] = std::array{ plane(width, 32, 1.f, source), plane(width, 32, 1.f, storage), plane(width, 1, 0.f, PlaneSamples{}) };
+			return std::pair{ fastest([&](auto isa) {
+				auto kernels = select_kernels(isa, 1ll, true);
+				sobel_plane(kernels, bytes(src), bytes(dst), stride * source.SampleBytes(), stride * storage.SampleBytes(), width, 32, 0, 32, .5, source, storage, scratch.data());
+			}), 0_size };
+		}).first;
+		tuned += " sobel "s + name(tuning.sobel);
+	}
+	if (filter == Filter::ABlur || filter == Filter::AWarpSharp) {
+		blur_level = std::max(blur_level, 1ll);
+		tuning.blur = cache.Lookup("blur " + geometry + " type " + std::to_string(blur_type) + " blur " + std::to_string(blur_level), [&] {
+			auto [src, dst] = std::array{ plane(width, 64, 1.f, PlaneSamples{}), plane(width, 64, 1.f, PlaneSamples{}) };
+			return std::pair{ fastest([&](auto isa) {
+				auto kernels = select_kernels(isa, blur_type, true);
+				auto buffer = std::vector<float>(blur_stream_rows(kernels, blur_level) * stride);
+				blur_stream(kernels, width, 64, 0, 64, blur_level, buffer.data(), stride,
+					[&](auto y, auto) { return static_cast<const float*>(src.data() + y * stride); },
+					[&](auto y) { return dst.data() + y * stride; },
+					[](auto) {});
+			}), 0_size };
+		}).first;
+		tuned += (tuned.empty() ? " blur "s : ", blur "s) + name(tuning.blur);
+	}
+	// only AWarp along a mask cuts its rows into strips, AWarpSharp and displacement fields warp whole rows.
+	if (filter == Filter::AWarp || filter == Filter::AWarpSharp) {
+		auto source_shift = taps != 0 ? 0 : SMAGL;
+		auto rows = 2 * warp_block_rows;
+		auto strips = filter == Filter::AWarp && displaced == false;
+		auto key = "warp " + geometry + " smagl " + std::to_string(SMAGL) + " taps " + std::to_string(taps) + (displaced ? " displaced" : strips ? "" : " rows");
+		std::tie(tuning.warp, tuning.cache_bytes) = cache.Lookup(key, [&] {
+			auto [source, samples] = std::array{ output.samples, input.samples };
+			auto src = plane(width << source_shift, rows << source_shift, 1.f, source);
+			auto [mask, dst] = std::array{ plane(width, rows, .25f, samples), plane(width, rows, 1.f, source) };
+			auto scratch = std::vector<float>(warp_scratch_rows() * stride);
+			auto targets = std::array{ WarpTarget{ bytes(src), bytes(dst), scratch_stride(width << source_shift) * static_cast<std::ptrdiff_t>(source.SampleBytes()),
+				stride * static_cast<std::ptrdiff_t>(source.SampleBytes()), width, rows, 16ll, 0, 0 } };
+			auto field = std::vector<std::int16_t>(2 * rows * stride);
+			for (auto i : Range{ field.size() })
+				field[i] = static_cast<std::int16_t>(i % 61 * 16) - 480;
+			auto warp = [&](auto isa, auto cache_bytes) {
+				auto kernels = select_kernels(isa, 1ll, true);
+				if (displaced)
+					warp_displaced(kernels, targets[0], reinterpret_cast<const std::uint8_t*>(field.data()), stride * 2_ptrdiff, 0, rows, SMAGL, taps, source, scratch.data(), stride);
+				else
+					warp_targets(kernels, targets, bytes(mask), stride * samples.SampleBytes(), width, rows, 0, 0, rows, SMAGL, taps, source, samples, scratch.data(), stride, cache_bytes);
+			};
+			auto whole_rows = std::numeric_limits<std::size_t>::max() / 1024;
+			auto isa = fastest([&](auto isa) { warp(isa, strips ? L2CacheBytes() : whole_rows); });
+			auto [best, cache_bytes] = std::pair{ 1e300, L2CacheBytes() };
+			auto widths = std::vector<int>{};
+			if (strips)
+				for (auto budget : { L2CacheBytes(), L2CacheBytes() / 2, L2CacheBytes() * 2, whole_rows })
+					if (auto strip = warp_strip_width(width, source.SampleBytes(), source_shift, budget); std::find(widths.begin(), widths.end(), strip) == widths.end()) {
+						widths.push_back(strip);
+						if (auto seconds = BestTime([&] { warp(isa, budget); }); seconds < best)
+							std::tie(best, cache_bytes) = std::pair{ seconds, budget };
+					}
+			return std::pair{ isa, cache_bytes };
+		});
+		tuned += (tuned.empty() ? " warp "s : ", warp "s) + name(tuning.warp);
+		if (strips)
+			tuned += " with strips for " + std::to_string(tuning.cache_bytes) + " bytes of cache";
+	}
+	// ADisplacement runs the gradient and displacement kernels of the warp family, and never warps.
+	if (filter == Filter::ADisplacement) {
+		tuning.warp = cache.Lookup("displacement " + geometry, [&] {
+			auto samples = input.samples;
+			auto mask = plane(width, 32, .25f, samples);
+			auto scratch = std::vector<float>(displacement_scratch_floats(width));
+			return std::pair{ fastest([&](auto isa) {
+				auto kernels = select_kernels(isa, 1ll, true);
+				gradient_rows(kernels, samples, bytes(mask), stride * samples.SampleBytes(), width, 32, 0, 32, scratch.data(), stride, 1, [&](auto gradient_h, auto gradient_v, auto) {
+					auto displacement_h = reinterpret_cast<int*>(scratch.data() + 5 * stride);
+					kernels.displacement_row(gradient_h, gradient_v, displacement_h, displacement_h + stride, width, 16ll, 0, 0);
+				});
+			}), 0_size };
+		}).first;
+		tuned += " displacement "s + name(tuning.warp);
+	}
+	return std::pair{ tuning, tuned };
+};
+}
+
+#undef self
+#undef Begin
+#undef End
\ No newline at end of file
@@ -1,7 +1,10 @@
-#pragma once
+// the shorthands the sources of this repository are written in. the macros and std::literals are private to them:
+// the definitions live in namespace warpsf, Core.hpp undefines the macros at its end, and a source file that uses them
+// after including Core.hpp includes this file again.
 #include <iostream>
 #include <string>
 #include <array>
+#include <vector>
 #include <type_traits>
 #include <algorithm>
 #include <utility>
@@ -15,6 +18,9 @@
 #define Begin begin
 #define End end
 
+#ifndef WARPSF_COSMETICS
+#define WARPSF_COSMETICS
+namespace warpsf {
 using namespace std::literals;
 
 constexpr auto operator""_size(unsigned long long Value) {
@@ -94,4 +100,6 @@ public:
 	auto End() const {
 		return Iterator{ Endpoint, Step };
 	}
-};
\ No newline at end of file
+};
+}
+#endif
\ No newline at end of file
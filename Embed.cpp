@@ -0,0 +1,60 @@
+// what an application embedding the filters sees: this file includes Core.hpp and nothing of the plugin, so it only
+// builds while Core.hpp needs no VapourSynth header and leaves no shorthand behind:
+//     g++ -std=c++17 -O2 -Wall -pthread Embed.cpp -o embed
+// "embed" tunes the kernels for a small gray frame, runs AWarpSharp on it and the same chain of ASobel, ABlur and AWarp
+// entry points by hand, and exits with 1 when they differ.
+#include "Core.hpp"
+#include <cstdio>
+
+#ifdef VAPOURSYNTH_H
+#error Core.hpp includes VapourSynth.h
+#endif
+#if defined(self) || defined(Begin) || defined(End)
+#error Core.hpp leaves the shorthand macros of Cosmetics.hpp defined
+#endif
+
+// names Core.hpp also declares, which would be ambiguous below if any of its using-directives reached this scope.
+struct Range final {};
+struct Half final {};
+struct ThreadPool final {};
+
+int main() {
+	constexpr auto width = 97;
+	constexpr auto height = 43;
+	constexpr auto stride = 128;
+	auto buffers = std::array{ std::vector<float>(stride * height), std::vector<float>(stride * height), std::vector<float>(stride * height), std::vector<float>(stride * height), std::vector<float>(stride * height) };
+	auto& [src, edges, mask, warped, sharpened] = buffers;
+	for (auto y = 0; y < height; ++y)
+		for (auto x = 0; x < width; ++x)
+			src[y * stride + x] = static_cast<float>((static_cast<std::uint32_t>(y * width + x) * 2654435761u) >> 16) / 65535.f;
+	auto read = [](auto& buffer) {
+		auto frame = warpsf::SourceFrame{};
+		frame.planes[0] = { reinterpret_cast<const std::uint8_t*>(buffer.data()), stride * 4, width, height };
+		return frame;
+	};
+	auto write = [](auto& buffer) {
+		auto frame = warpsf::TargetFrame{};
+		frame.planes[0] = { reinterpret_cast<std::uint8_t*>(buffer.data()), stride * 4, width, height };
+		return frame;
+	};
+	auto [thresh, blur_type, blur_level] = std::tuple{ 128., 0ll, 2ll };
+	auto depth = std::array{ 24ll, 0ll, 0ll };
+	auto options = warpsf::CoreOptions{};
+	auto gray = warpsf::ClipFormat{};
+	options.tuning = warpsf::tune_kernels(options.tuning, warpsf::Filter::AWarpSharp, width, height, gray, gray, blur_type, blur_level, 0, 0, false).first;
+	auto arena = warpsf::ScratchArena::Shared();
+	options.arena = arena.get();
+	auto only_luma = std::array{ true, false, false };
+	warpsf::sobel_frame(options, read(src), write(edges), only_luma, thresh / 256.);
+	warpsf::blur_frame(options, read(edges), write(mask), blur_type, std::array{ blur_level, 0ll, 0ll }, nullptr);
+	auto srcs = std::vector{ read(src) };
+	auto dsts = std::vector{ write(warped) };
+	warpsf::warp_frames(options, srcs, dsts, read(mask), depth, false, false, 0, 0);
+	warpsf::sharpen_frame(options, read(src), write(sharpened), thresh / 256., blur_type, blur_level, depth, false);
+	auto differing = 0;
+	for (auto y = 0; y < height; ++y)
+		for (auto x = 0; x < width; ++x)
+			differing += warped[y * stride + x] != sharpened[y * stride + x];
+	std::printf("AWarpSharp against ASobel, ABlur and AWarp: %d of %d samples differ\n", differing, width * height);
+	return differing == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,294 @@
+#pragma once
+#include "Cosmetics.hpp"
+#include "VapourSynth.h"
+#include "VSHelper.h"
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <variant>
+
+// an in-process stand-in for the parts of the VapourSynth core the plugin talks to, for the benchmark and the
+// verification harness. frames are produced synchronously on the calling thread: getFrameFilter runs the upstream
+// filter's arInitial and arAllFramesReady steps back to back, or only arInitial when that already returns the frame, as
+// a filter that needs no frames may. include after Source.cpp.
+
+struct VSMap final {
+	using Value = std::variant<std::int64_t, double, std::string, std::shared_ptr<VSNodeRef>, std::shared_ptr<const VSFrameRef>>;
+	std::map<std::string, std::vector<Value>> props;
+	self(error, ""s);
+};
+
+struct VSFrameRef final {
+	self(format, static_cast<const VSFormat*>(nullptr));
+	self(width, std::array{ 0, 0, 0 });
+	self(height, std::array{ 0, 0, 0 });
+	self(stride, std::array{ 0, 0, 0 });
+	self(planes, (std::array<std::shared_ptr<std::uint8_t>, 3>{}));
+	self(props, VSMap{});
+};
+
+struct VSNode final {
+	self(outputs, std::vector<VSVideoInfo>{});
+	self(produce, (std::function<VSFrameRef* (int, int)>{}));
+	self(getFrame, static_cast<VSFilterGetFrame>(nullptr));
+	self(free, static_cast<VSFilterFree>(nullptr));
+	self(instanceData, static_cast<void*>(nullptr));
+	self(core, static_cast<VSCore*>(nullptr));
+	self(api, static_cast<const VSAPI*>(nullptr));
+	// frames requested from this node, by requestFrameFilter.
+	self(requests, 0);
+	~VSNode() {
+		if (free != nullptr)
+			free(instanceData, core, api);
+	}
+};
+
+struct VSNodeRef final {
+	self(node, std::shared_ptr<VSNode>{});
+	self(index, 0);
+};
+
+struct VSFrameContext final {
+	self(index, 0);
+	self(error, ""s);
+};
+
+struct VSCore final {
+	self(api, static_cast<const VSAPI*>(nullptr));
+	self(stride_padding, 0);
+	std::list<VSFormat> formats;
+};
+
+struct VSPlugin final {
+	std::map<std::string, std::pair<VSPublicFunction, void*>> functions;
+};
+
+class MockCore final {
+	VSAPI api = {};
+	VSCore core;
+	VSPlugin plugin;
+	static auto Lookup(const VSMap* map, const char* key, int index, int* error) {
+		auto value = static_cast<const VSMap::Value*>(nullptr);
+		auto code = 0;
+		if (auto x = map->props.find(key); x == map->props.end())
+			code = peUnset;
+		else if (index < 0 || index >= static_cast<int>(x->second.size()))
+			code = peIndex;
+		else
+			value = &x->second[index];
+		if (error != nullptr)
+			*error = code;
+		else if (code != 0) {
+			std::cerr << "MockCore: missing property " << key << std::endl;
+			std::abort();
+		}
+		return value;
+	}
+	template<typename T>
+	static auto Get(const VSMap* map, const char* key, int index, int* error) {
+		auto value = Lookup(map, key, index, error);
+		if (value == nullptr)
+			return T{};
+		if (auto x = std::get_if<T>(value); x != nullptr)
+			return *x;
+		if (error != nullptr)
+			*error = peType;
+		return T{};
+	}
+	static auto Set(VSMap* map, const char* key, VSMap::Value value, int append) {
+		auto& entry = map->props[key];
+		if (append == paReplace)
+			entry.clear();
+		entry.push_back(std::move(value));
+		return 0;
+	}
+	static auto Allocate(const VSFormat* format, int width, int height, VSCore* core) {
+		auto frame = new VSFrameRef{};
+		frame->format = format;
+		for (auto plane : Range{ format->numPlanes }) {
+			frame->width[plane] = plane == 0 ? width : width >> format->subSamplingW;
+			frame->height[plane] = plane == 0 ? height : height >> format->subSamplingH;
+			frame->stride[plane] = (frame->width[plane] * format->bytesPerSample + 63) / 64 * 64 + core->stride_padding;
+			frame->planes[plane] = std::shared_ptr<std::uint8_t>{ vs_aligned_malloc<std::uint8_t>(static_cast<std::size_t>(frame->stride[plane]) * frame->height[plane] + 64, 64), vs_aligned_free };
+		}
+		return frame;
+	}
+	static auto Produce(VSNodeRef* ref, int n, VSCore* core, const VSAPI* api, std::string& error) {
+		auto& node = *ref->node;
+		if (node.produce)
+			return static_cast<const VSFrameRef*>(node.produce(n, ref->index));
+		auto frameData = static_cast<void*>(nullptr);
+		auto context = VSFrameContext{ ref->index };
+		if (auto frame = node.getFrame(n, arInitial, &node.instanceData, &frameData, &context, core, api); frame != nullptr)
+			return frame;
+		auto frame = node.getFrame(n, arAllFramesReady, &node.instanceData, &frameData, &context, core, api);
+		if (frame == nullptr)
+			error = context.error.empty() ? "MockCore: filter returned no frame."s : context.error;
+		return frame;
+	}
+public:
+	MockCore() {
+		core.api = &api;
+		api.createMap = []() noexcept { return new VSMap{}; };
+		api.freeMap = [](auto map) noexcept { delete map; };
+		api.clearMap = [](auto map) noexcept { *map = VSMap{}; };
+		api.setError = [](auto map, auto message) noexcept { map->error = message; };
+		api.getError = [](auto map) noexcept { return map->error.empty() ? static_cast<const char*>(nullptr) : map->error.data(); };
+		api.setFilterError = [](auto message, auto frameCtx) noexcept { frameCtx->error = message; };
+		api.logMessage = [](auto, auto) noexcept {};
+		api.propNumElements = [](auto map, auto key) noexcept {
+			auto x = map->props.find(key);
+			return x == map->props.end() ? -1 : static_cast<int>(x->second.size());
+		};
+		api.propGetInt = [](auto map, auto key, auto index, auto error) noexcept { return Get<std::int64_t>(map, key, index, error); };
+		api.propGetFloat = [](auto map, auto key, auto index, auto error) noexcept { return Get<double>(map, key, index, error); };
+		api.propGetData = [](auto map, auto key, auto index, auto error) noexcept {
+			auto value = Lookup(map, key, index, error);
+			auto x = value == nullptr ? nullptr : std::get_if<std::string>(value);
+			return x == nullptr ? static_cast<const char*>(nullptr) : x->data();
+		};
+		api.propGetNode = [](auto map, auto key, auto index, auto error) noexcept {
+			auto x = Get<std::shared_ptr<VSNodeRef>>(map, key, index, error);
+			return x == nullptr ? static_cast<VSNodeRef*>(nullptr) : new VSNodeRef{ *x };
+		};
+		api.propGetFrame = [](auto map, auto key, auto index, auto error) noexcept { return Get<std::shared_ptr<const VSFrameRef>>(map, key, index, error).get(); };
+		api.propSetInt = [](auto map, auto key, auto x, auto append) noexcept { return Set(map, key, x, append); };
+		api.propSetFloat = [](auto map, auto key, auto x, auto append) noexcept { return Set(map, key, x, append); };
+		api.propSetData = [](auto map, auto key, auto data, auto size, auto append) noexcept {
+			return Set(map, key, size < 0 ? std::string{ data } : std::string{ data, static_cast<std::size_t>(size) }, append);
+		};
+		api.propSetNode = [](auto map, auto key, auto node, auto append) noexcept { return Set(map, key, std::make_shared<VSNodeRef>(*node), append); };
+		api.propDeleteKey = [](auto map, auto key) noexcept { return static_cast<int>(map->props.erase(key)); };
+		api.getFramePropsRO = [](auto frame) noexcept { return static_cast<const VSMap*>(&frame->props); };
+		api.getFramePropsRW = [](auto frame) noexcept { return &frame->props; };
+		api.getVideoInfo = [](auto ref) noexcept { return static_cast<const VSVideoInfo*>(&ref->node->outputs[ref->index]); };
+		api.setVideoInfo = [](auto vi, auto numOutputs, auto node) noexcept { node->outputs.assign(vi, vi + numOutputs); };
+		api.getOutputIndex = [](auto frameCtx) noexcept { return frameCtx->index; };
+		api.cloneNodeRef = [](auto ref) noexcept { return new VSNodeRef{ *ref }; };
+		api.freeNode = [](auto ref) noexcept { delete ref; };
+		api.getFrameFormat = [](auto frame) noexcept { return frame->format; };
+		api.getFrameWidth = [](auto frame, auto plane) noexcept { return frame->width[plane]; };
+		api.getFrameHeight = [](auto frame, auto plane) noexcept { return frame->height[plane]; };
+		api.getStride = [](auto frame, auto plane) noexcept { return frame->stride[plane]; };
+		api.getReadPtr = [](auto frame, auto plane) noexcept { return static_cast<const std::uint8_t*>(frame->planes[plane].get()); };
+		api.getWritePtr = [](auto frame, auto plane) noexcept {
+			if (auto& data = frame->planes[plane]; data.use_count() > 1) {
+				auto size = static_cast<std::size_t>(frame->stride[plane]) * frame->height[plane];
+				auto copy = std::shared_ptr<std::uint8_t>{ vs_aligned_malloc<std::uint8_t>(size + 64, 64), vs_aligned_free };
+				std::memcpy(copy.get(), data.get(), size);
+				data = copy;
+			}
+			return frame->planes[plane].get();
+		};
+		api.cloneFrameRef = [](auto frame) noexcept { return static_cast<const VSFrameRef*>(new VSFrameRef{ *frame }); };
+		api.copyFrame = [](auto frame, auto) noexcept { return new VSFrameRef{ *frame }; };
+		api.freeFrame = [](auto frame) noexcept { delete frame; };
+		api.newVideoFrame = [](auto format, auto width, auto height, auto propSrc, auto core) noexcept {
+			auto frame = Allocate(format, width, height, core);
+			if (propSrc != nullptr)
+				frame->props = propSrc->props;
+			return frame;
+		};
+		api.newVideoFrame2 = [](auto format, auto width, auto height, auto planeSrc, auto planes, auto propSrc, auto core) noexcept {
+			auto frame = Allocate(format, width, height, core);
+			for (auto plane : Range{ format->numPlanes })
+				if (planeSrc[plane] != nullptr) {
+					frame->planes[plane] = planeSrc[plane]->planes[planes[plane]];
+					frame->stride[plane] = planeSrc[plane]->stride[planes[plane]];
+				}
+			if (propSrc != nullptr)
+				frame->props = propSrc->props;
+			return frame;
+		};
+		api.requestFrameFilter = [](auto, auto ref, auto) noexcept { ++ref->node->requests; };
+		api.releaseFrameEarly = [](auto, auto, auto) noexcept {};
+		api.getFrameFilter = [](auto n, auto ref, auto frameCtx) noexcept {
+			auto& node = *ref->node;
+			return Produce(ref, n, node.core, node.api, frameCtx->error);
+		};
+		api.createFilter = [](auto in, auto out, auto, auto init, auto getFrame, auto free, auto, auto, auto instanceData, auto core) noexcept {
+			auto node = std::make_shared<VSNode>();
+			node->getFrame = getFrame;
+			node->instanceData = instanceData;
+			node->core = core;
+			node->api = core->api;
+			init(const_cast<VSMap*>(in), out, &node->instanceData, node.get(), core, node->api);
+			node->free = free;
+			for (auto index : Range{ node->outputs.size() })
+				Set(out, "clip", std::make_shared<VSNodeRef>(VSNodeRef{ node, static_cast<int>(index) }), paAppend);
+		};
+		api.registerFormat = [](auto colorFamily, auto sampleType, auto bitsPerSample, auto subSamplingW, auto subSamplingH, auto core) noexcept {
+			for (auto& x : core->formats)
+				if (x.colorFamily == colorFamily && x.sampleType == sampleType && x.bitsPerSample == bitsPerSample && x.subSamplingW == subSamplingW && x.subSamplingH == subSamplingH)
+					return static_cast<const VSFormat*>(&x);
+			auto& x = core->formats.emplace_back();
+			x.id = static_cast<int>(core->formats.size());
+			x.colorFamily = colorFamily;
+			x.sampleType = sampleType;
+			x.bitsPerSample = bitsPerSample;
+			x.bytesPerSample = bitsPerSample > 16 ? 4 : bitsPerSample > 8 ? 2 : 1;
+			x.subSamplingW = colorFamily == cmGray ? 0 : subSamplingW;
+			x.subSamplingH = colorFamily == cmGray ? 0 : subSamplingH;
+			x.numPlanes = colorFamily == cmGray ? 1 : 3;
+			return static_cast<const VSFormat*>(&x);
+		};
+		VapourSynthPluginInit([](auto, auto, auto, auto, auto, auto) {}, [](auto name, auto, auto argsFunc, auto functionData, auto plugin) {
+			plugin->functions[name] = { argsFunc, functionData };
+		}, &plugin);
+	}
+	MockCore(MockCore&&) = delete;
+	MockCore(const MockCore&) = delete;
+	auto operator=(MockCore&&)->decltype(*this) = delete;
+	auto operator=(const MockCore&)->decltype(*this) = delete;
+	~MockCore() = default;
+	static auto& Instance() {
+		static auto mock = MockCore{};
+		return mock;
+	}
+	auto API() {
+		return static_cast<const VSAPI*>(&api);
+	}
+	auto SetStridePadding(int bytes) {
+		core.stride_padding = bytes;
+	}
+	auto Format(int colorFamily, int sampleType, int bitsPerSample, int subSamplingW = 0, int subSamplingH = 0) {
+		return api.registerFormat(colorFamily, sampleType, bitsPerSample, subSamplingW, subSamplingH, &core);
+	}
+	auto NewFrame(const VSFormat* format, int width, int height) {
+		return Allocate(format, width, height, &core);
+	}
+	// a clip of numFrames identical frames, filled once by fill(frame) and handed out as new references to the same planes.
+	auto Source(const VSFormat* format, int width, int height, int numFrames, std::function<void(VSFrameRef*)> fill) {
+		auto node = std::make_shared<VSNode>();
+		auto frame = std::shared_ptr<VSFrameRef>{ Allocate(format, width, height, &core) };
+		fill(frame.get());
+		node->outputs.push_back(VSVideoInfo{ format, 25, 1, width, height, numFrames, 0 });
+		node->produce = [=](auto, auto) { return new VSFrameRef{ *frame }; };
+		return std::make_shared<VSNodeRef>(VSNodeRef{ node, 0 });
+	}
+	// calls a registered function; the result holds "clip" on success, or the error message.
+	auto Invoke(const std::string& name, const VSMap& args) {
+		auto out = VSMap{};
+		auto [create, functionData] = plugin.functions.at(name);
+		create(&args, &out, functionData, &core, &api);
+		return out;
+	}
+	auto GetFrame(const std::shared_ptr<VSNodeRef>& clip, int n) {
+		auto error = ""s;
+		auto frame = std::unique_ptr<const VSFrameRef, void(*)(const VSFrameRef*)>{ Produce(clip.get(), n, &core, &api, error), [](auto x) { delete x; } };
+		if (frame == nullptr)
+			std::cerr << error << std::endl;
+		return frame;
+	}
+	static auto Clip(const VSMap& out, int index = 0) {
+		return Get<std::shared_ptr<VSNodeRef>>(&out, "clip", index, nullptr);
+	}
+	static auto Count(const VSMap& out, const char* key) {
+		auto x = out.props.find(key);
+		return x == out.props.end() ? 0 : static_cast<int>(x->second.size());
+	}
+	static auto Arg(VSMap& args, const char* key, VSMap::Value value) {
+		Set(&args, key, std::move(value), paAppend);
+	}
+};
\ No newline at end of file
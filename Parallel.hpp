@@ -0,0 +1,123 @@
+#pragma once
+#include "Cosmetics.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace warpsf {
+
+// one pool per process, shared by every filter instance. the thread that posts a job always works on it, and pool
+// workers only steal tasks from jobs in flight while fewer than HardwareThreads() threads are busy in this plugin, so
+// frame-level parallelism in VapourSynth and band-level parallelism here never add up to more threads than cores.
+class ThreadPool final {
+	struct Job final {
+		self(body, std::function<void(std::ptrdiff_t)>{});
+		self(count, 0_ptrdiff);
+		self(helpers, 0_ptrdiff);
+		std::atomic<std::ptrdiff_t> next{ 0 };
+		std::atomic<std::ptrdiff_t> remaining{ 0 };
+		std::atomic<std::ptrdiff_t> joined{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+		auto Drain() {
+			for (auto i = next++; i < count; i = next++)
+				if (body(i); --remaining == 0) {
+					auto lock = std::lock_guard{ mutex };
+					finished.notify_all();
+				}
+		}
+	};
+	std::mutex mutex;
+	std::condition_variable posted;
+	std::list<std::shared_ptr<Job>> jobs;
+	std::vector<std::thread> workers;
+	self(busy, 0_ptrdiff);
+	self(stopping, false);
+	auto Steal() {
+		for (auto& job : jobs)
+			if (job->next < job->count && job->joined < job->helpers)
+				return job;
+		return std::shared_ptr<Job>{};
+	}
+	auto Leave() {
+		{
+			auto lock = std::lock_guard{ mutex };
+			--busy;
+		}
+		posted.notify_one();
+	}
+	auto Work() {
+		for (;;) {
+			auto job = std::shared_ptr<Job>{};
+			{
+				auto lock = std::unique_lock{ mutex };
+				posted.wait(lock, [&] { return stopping || (busy < HardwareThreads() && (job = Steal()) != nullptr); });
+				if (stopping)
+					return;
+				++job->joined;
+				++busy;
+			}
+			job->Drain();
+			Leave();
+		}
+	}
+	ThreadPool() {
+		for ([[maybe_unused]] auto _ : Range{ HardwareThreads() - 1 })
+			workers.emplace_back([this] { Work(); });
+	}
+public:
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool(const ThreadPool&) = delete;
+	auto operator=(ThreadPool&&)->decltype(*this) = delete;
+	auto operator=(const ThreadPool&)->decltype(*this) = delete;
+	~ThreadPool() {
+		{
+			auto lock = std::lock_guard{ mutex };
+			stopping = true;
+		}
+		posted.notify_all();
+		for (auto& x : workers)
+			x.join();
+	}
+	static auto HardwareThreads() -> std::ptrdiff_t {
+		static const auto n = std::max(static_cast<std::ptrdiff_t>(std::thread::hardware_concurrency()), 1_ptrdiff);
+		return n;
+	}
+	static auto& Instance() {
+		static auto pool = ThreadPool{};
+		return pool;
+	}
+	// runs body(0) ... body(count - 1) on the calling thread and up to threads - 1 pool workers, returns when all are done.
+	template<typename BodyType>
+	auto Run(std::ptrdiff_t threads, std::ptrdiff_t count, BodyType&& body) {
+		if (threads <= 1 || count <= 1) {
+			for (auto i : Range{ count })
+				body(i);
+			return;
+		}
+		auto job = std::make_shared<Job>();
+		job->body = [&](auto i) { body(i); };
+		job->count = count;
+		job->helpers = std::min<std::ptrdiff_t>(threads, count) - 1;
+		job->remaining = count;
+		{
+			auto lock = std::lock_guard{ mutex };
+			jobs.push_back(job);
+			++busy;
+		}
+		posted.notify_all();
+		job->Drain();
+		Leave();
+		{
+			auto lock = std::unique_lock{ job->mutex };
+			job->finished.wait(lock, [&] { return job->remaining == 0; });
+		}
+		auto lock = std::lock_guard{ mutex };
+		jobs.remove(job);
+	}
+};
+}
\ No newline at end of file
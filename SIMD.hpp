@@ -0,0 +1,454 @@
+#pragma once
+#include "Cosmetics.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WARPSF_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#define WARPSF_STRINGIFY(...) #__VA_ARGS__
+#if defined(__clang__)
+#define WARPSF_TARGET_BEGIN(isa) _Pragma(WARPSF_STRINGIFY(clang attribute push(__attribute__((target(isa))), apply_to = function)))
+#define WARPSF_TARGET_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define WARPSF_TARGET_BEGIN(isa) _Pragma("GCC push_options") _Pragma(WARPSF_STRINGIFY(GCC target(isa)))
+#define WARPSF_TARGET_END _Pragma("GCC pop_options")
+#else
+#define WARPSF_TARGET_BEGIN(isa)
+#define WARPSF_TARGET_END
+#endif
+
+namespace warpsf {
+enum class ISA {
+	None,
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+#ifdef WARPSF_X86
+inline auto cpuid = [](auto leaf, auto subleaf) {
+	auto regs = std::array<unsigned int, 4>{};
+#if defined(_MSC_VER)
+	auto info = std::array<int, 4>{};
+	__cpuidex(info.data(), leaf, subleaf);
+	for (auto i : Range{ 4 })
+		regs[i] = static_cast<unsigned int>(info[i]);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	return regs;
+};
+#endif
+
+inline auto DetectISA = []() {
+	auto isa = ISA::None;
+#ifdef WARPSF_X86
+	auto xgetbv = []() {
+#if defined(_MSC_VER)
+		return static_cast<unsigned long long>(_xgetbv(0));
+#else
+		auto eax = 0u, edx = 0u;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return static_cast<unsigned long long>(edx) << 32 | eax;
+#endif
+	};
+	auto bit = [](auto reg, auto pos) { return (reg >> pos & 1) != 0; };
+	auto max_leaf = cpuid(0, 0)[0];
+	auto leaf1 = cpuid(1, 0);
+	if (bit(leaf1[3], 26))
+		isa = ISA::SSE2;
+	if (max_leaf < 7 || !bit(leaf1[2], 27))
+		return isa;
+	auto leaf7 = cpuid(7, 0);
+	auto xcr0 = xgetbv();
+	auto os_ymm = (xcr0 & 0x06) == 0x06;
+	auto os_zmm = (xcr0 & 0xe6) == 0xe6;
+	if (os_ymm && bit(leaf1[2], 28) && bit(leaf1[2], 12) && bit(leaf1[2], 29) && bit(leaf7[1], 5))
+		isa = ISA::AVX2;
+	if (isa == ISA::AVX2 && os_zmm && bit(leaf7[1], 16) && bit(leaf7[1], 17) && bit(leaf7[1], 30) && bit(leaf7[1], 31))
+		isa = ISA::AVX512;
+#endif
+	return isa;
+};
+
+inline auto SupportedISA = []() {
+	static const auto isa = DetectISA();
+	return isa;
+};
+
+// the L2 size per core from the extended cpuid leaf both Intel and AMD report it in, 1 MiB where it is not available.
+inline auto L2CacheBytes = []() {
+	static const auto bytes = []() {
+		auto size = 1_size << 20;
+#ifdef WARPSF_X86
+		if (cpuid(0x80000000u, 0)[0] >= 0x80000006u)
+			if (auto kib = cpuid(0x80000006u, 0)[2] >> 16; kib != 0)
+				size = static_cast<std::size_t>(kib) << 10;
+#endif
+		return size;
+	}();
+	return bytes;
+};
+
+// IEEE 754 binary16, the storage of half float masks. both conversions round to nearest even, like F16C.
+struct Half final {
+	std::uint16_t bits;
+};
+
+inline auto half_to_float = [](Half x) {
+	auto sign = static_cast<std::uint32_t>(x.bits & 0x8000) << 16;
+	auto exponent = x.bits >> 10 & 0x1f;
+	auto mantissa = static_cast<std::uint32_t>(x.bits & 0x3ff);
+	auto bits = sign;
+	if (exponent == 0) {
+		auto value = std::ldexp(static_cast<float>(mantissa), -24);
+		std::memcpy(&bits, &value, sizeof(bits));
+		bits |= sign;
+	}
+	else if (exponent == 0x1f)
+		bits |= 0x7f800000 | mantissa << 13;
+	else
+		bits |= static_cast<std::uint32_t>(exponent + 112) << 23 | mantissa << 13;
+	auto value = 0.f;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+};
+
+inline auto float_to_half = [](float x) {
+	auto bits = std::uint32_t{};
+	std::memcpy(&bits, &x, sizeof(bits));
+	auto sign = static_cast<std::uint16_t>(bits >> 16 & 0x8000);
+	bits &= 0x7fffffff;
+	if (bits >= 0x47800000)
+		return Half{ static_cast<std::uint16_t>(sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00)) };
+	if (bits < 0x38800000) {
+		// below the smallest normal half, adding 0.5 leaves the rounded mantissa in the low bits.
+		auto value = std::abs(x) + .5f;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return Half{ static_cast<std::uint16_t>(sign | (bits - 0x3f000000)) };
+	}
+	bits += 0xc8000fff + (bits >> 13 & 1);
+	return Half{ static_cast<std::uint16_t>(sign | bits >> 13) };
+};
+
+// one lane of plain float and int arithmetic. gives the single precision kernels on every architecture, and is what
+// opt=1 runs unless precision=1 asks for the double precision reference.
+namespace Portable {
+	struct Vector final {
+		static constexpr auto Width = 1;
+		float v;
+	};
+	inline auto broadcast(float x) { return Vector{ x }; }
+	inline auto load(const float* p) { return Vector{ *p }; }
+	inline auto load(const float* p, int) { return Vector{ *p }; }
+	inline auto store(float* p, Vector x) { *p = x.v; }
+	inline auto store(float* p, Vector x, int) { *p = x.v; }
+	inline auto load(const std::uint8_t* p, int = 1) { return Vector{ static_cast<float>(*p) }; }
+	inline auto load(const std::uint16_t* p, int = 1) { return Vector{ static_cast<float>(*p) }; }
+	inline auto load(const Half* p, int = 1) { return Vector{ half_to_float(*p) }; }
+	inline auto store(std::uint8_t* p, Vector x, int = 1) { *p = static_cast<std::uint8_t>(std::nearbyint(std::min(std::max(x.v, 0.f), 255.f))); }
+	inline auto store(std::uint16_t* p, Vector x, int = 1) { *p = static_cast<std::uint16_t>(std::nearbyint(std::min(std::max(x.v, 0.f), 65535.f))); }
+	inline auto store(Half* p, Vector x, int = 1) { *p = float_to_half(x.v); }
+	inline auto operator+(Vector a, Vector b) { return Vector{ a.v + b.v }; }
+	inline auto operator-(Vector a, Vector b) { return Vector{ a.v - b.v }; }
+	inline auto operator*(Vector a, Vector b) { return Vector{ a.v * b.v }; }
+#ifdef FP_FAST_FMAF
+	inline auto fmadd(Vector a, Vector b, Vector c) { return Vector{ std::fma(a.v, b.v, c.v) }; }
+#else
+	inline auto fmadd(Vector a, Vector b, Vector c) { return a * b + c; }
+#endif
+	inline auto min(Vector a, Vector b) { return Vector{ std::min(a.v, b.v) }; }
+	inline auto max(Vector a, Vector b) { return Vector{ std::max(a.v, b.v) }; }
+	inline auto abs(Vector a) { return Vector{ std::abs(a.v) }; }
+	inline auto for_each_group = [](auto begin, auto end, auto group) {
+		for (auto x : Range{ begin, end, 1 })
+			group(x);
+	};
+
+	struct Integer final {
+		int v;
+	};
+	struct Mask final {
+		bool v;
+	};
+	inline auto broadcast(int x) { return Integer{ x }; }
+	inline auto iota() { return Integer{ 0 }; }
+	inline auto to_integer(Vector x) { return Integer{ static_cast<int>(std::nearbyint(x.v)) }; }
+	inline auto to_float(Integer x) { return Vector{ static_cast<float>(x.v) }; }
+	inline auto operator+(Integer a, Integer b) { return Integer{ a.v + b.v }; }
+	inline auto operator-(Integer a, Integer b) { return Integer{ a.v - b.v }; }
+	inline auto operator*(Integer a, Integer b) { return Integer{ a.v * b.v }; }
+	inline auto operator&(Integer a, Integer b) { return Integer{ a.v & b.v }; }
+	inline auto operator<<(Integer a, int n) { return Integer{ static_cast<int>(static_cast<unsigned int>(a.v) << n) }; }
+	inline auto operator>>(Integer a, int n) { return Integer{ a.v >> n }; }
+	inline auto min(Integer a, Integer b) { return Integer{ std::min(a.v, b.v) }; }
+	inline auto max(Integer a, Integer b) { return Integer{ std::max(a.v, b.v) }; }
+	inline auto operator>(Integer a, Integer b) { return Mask{ a.v > b.v }; }
+	inline auto operator&(Mask a, Mask b) { return Mask{ a.v && b.v }; }
+	inline auto select(Mask m, Integer a, Integer b) { return m.v ? a : b; }
+	inline auto operator>>(Integer a, Integer n) { return Integer{ a.v >> n.v }; }
+	inline auto gather(const float* base, Integer index) { return Vector{ base[index.v] }; }
+	// the 32 bits starting at an integer sample, so it and the samples after it come out from the low bits up.
+	inline auto gather(const std::uint8_t* base, Integer index) {
+		auto word = 0;
+		std::memcpy(&word, base + index.v, sizeof(word));
+		return Integer{ word };
+	}
+	inline auto gather(const std::uint16_t* base, Integer index) {
+		auto word = 0;
+		std::memcpy(&word, base + index.v, sizeof(word));
+		return Integer{ word };
+	}
+	inline auto load(const int* p, int = 1) { return Integer{ *p }; }
+	inline auto store(int* p, Integer x, int = 1) { *p = x.v; }
+	inline auto gather(const int* base, Integer index) { return Integer{ base[index.v] }; }
+}
+
+#ifdef WARPSF_X86
+// gcc notes that passing vectors by value changed ABI, which only concerns exported functions and these are not.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+WARPSF_TARGET_BEGIN("sse2")
+namespace SSE2 {
+	struct Vector final {
+		static constexpr auto Width = 4;
+		__m128 v;
+	};
+	inline auto broadcast(float x) { return Vector{ _mm_set1_ps(x) }; }
+	inline auto load(const float* p) { return Vector{ _mm_loadu_ps(p) }; }
+	inline auto load(const float* p, int n) {
+		alignas(16) auto buffer = std::array<float, Vector::Width>{};
+		std::memcpy(buffer.data(), p, n * sizeof(float));
+		return Vector{ _mm_load_ps(buffer.data()) };
+	}
+	inline auto store(float* p, Vector x) { _mm_storeu_ps(p, x.v); }
+	inline auto store(float* p, Vector x, int n) {
+		alignas(16) auto buffer = std::array<float, Vector::Width>{};
+		_mm_store_ps(buffer.data(), x.v);
+		std::memcpy(p, buffer.data(), n * sizeof(float));
+	}
+	inline auto load(const std::uint8_t* p) {
+		auto bytes = 0;
+		std::memcpy(&bytes, p, sizeof(bytes));
+		auto words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), _mm_setzero_si128());
+		return Vector{ _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128())) };
+	}
+	inline auto load(const std::uint16_t* p) {
+		auto words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		return Vector{ _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128())) };
+	}
+	inline auto load(const Half* p) {
+		alignas(16) auto buffer = std::array<float, Vector::Width>{};
+		for (auto i : Range{ Vector::Width })
+			buffer[i] = half_to_float(p[i]);
+		return Vector{ _mm_load_ps(buffer.data()) };
+	}
+	inline auto store(std::uint8_t* p, Vector x) {
+		auto words = _mm_packs_epi32(_mm_cvtps_epi32(x.v), _mm_setzero_si128());
+		auto bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+		std::memcpy(p, &bytes, sizeof(bytes));
+	}
+	// no unsigned 32 to 16 bit pack before SSE4.1, so saturate around the signed range and flip the sign bit back.
+	inline auto store(std::uint16_t* p, Vector x) {
+		auto biased = _mm_sub_epi32(_mm_cvtps_epi32(x.v), _mm_set1_epi32(32768));
+		auto words = _mm_xor_si128(_mm_packs_epi32(biased, biased), _mm_set1_epi16(-32768));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(p), words);
+	}
+	inline auto store(Half* p, Vector x) {
+		alignas(16) auto buffer = std::array<float, Vector::Width>{};
+		_mm_store_ps(buffer.data(), x.v);
+		for (auto i : Range{ Vector::Width })
+			p[i] = float_to_half(buffer[i]);
+	}
+	template<typename Sample>
+	inline auto load(const Sample* p, int n) {
+		auto buffer = std::array<Sample, Vector::Width>{};
+		std::memcpy(buffer.data(), p, n * sizeof(Sample));
+		return load(buffer.data());
+	}
+	template<typename Sample>
+	inline auto store(Sample* p, Vector x, int n) {
+		auto buffer = std::array<Sample, Vector::Width>{};
+		store(buffer.data(), x);
+		std::memcpy(p, buffer.data(), n * sizeof(Sample));
+	}
+	inline auto operator+(Vector a, Vector b) { return Vector{ _mm_add_ps(a.v, b.v) }; }
+	inline auto operator-(Vector a, Vector b) { return Vector{ _mm_sub_ps(a.v, b.v) }; }
+	inline auto operator*(Vector a, Vector b) { return Vector{ _mm_mul_ps(a.v, b.v) }; }
+	inline auto fmadd(Vector a, Vector b, Vector c) { return a * b + c; }
+	inline auto min(Vector a, Vector b) { return Vector{ _mm_min_ps(a.v, b.v) }; }
+	inline auto max(Vector a, Vector b) { return Vector{ _mm_max_ps(a.v, b.v) }; }
+	inline auto abs(Vector a) { return Vector{ _mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))) }; }
+	inline auto for_each_group = [](auto begin, auto end, auto group) {
+		auto vectorized = (end - begin) / Vector::Width * Vector::Width;
+		for (auto x : Range{ begin, begin + vectorized, Vector::Width })
+			group(x);
+		if (auto remaining = static_cast<int>(end - begin - vectorized); remaining > 0)
+			group(begin + vectorized, remaining);
+	};
+}
+WARPSF_TARGET_END
+
+WARPSF_TARGET_BEGIN("avx2,fma,f16c")
+namespace AVX2 {
+	struct Vector final {
+		static constexpr auto Width = 8;
+		__m256 v;
+	};
+	inline auto tail_mask(int n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+	inline auto broadcast(float x) { return Vector{ _mm256_set1_ps(x) }; }
+	inline auto load(const float* p) { return Vector{ _mm256_loadu_ps(p) }; }
+	inline auto load(const float* p, int n) { return Vector{ _mm256_maskload_ps(p, tail_mask(n)) }; }
+	inline auto store(float* p, Vector x) { _mm256_storeu_ps(p, x.v); }
+	inline auto store(float* p, Vector x, int n) { _mm256_maskstore_ps(p, tail_mask(n), x.v); }
+	inline auto load(const std::uint8_t* p) { return Vector{ _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))) }; }
+	inline auto load(const std::uint16_t* p) { return Vector{ _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))) }; }
+	inline auto load(const Half* p) { return Vector{ _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) }; }
+	inline auto pack_words(Vector x) {
+		auto dwords = _mm256_cvtps_epi32(x.v);
+		return _mm_packus_epi32(_mm256_castsi256_si128(dwords), _mm256_extracti128_si256(dwords, 1));
+	}
+	inline auto store(std::uint8_t* p, Vector x) {
+		auto words = pack_words(x);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(words, words));
+	}
+	inline auto store(std::uint16_t* p, Vector x) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), pack_words(x)); }
+	inline auto store(Half* p, Vector x) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(x.v, _MM_FROUND_TO_NEAREST_INT)); }
+	template<typename Sample>
+	inline auto load(const Sample* p, int n) {
+		auto buffer = std::array<Sample, Vector::Width>{};
+		std::memcpy(buffer.data(), p, n * sizeof(Sample));
+		return load(buffer.data());
+	}
+	template<typename Sample>
+	inline auto store(Sample* p, Vector x, int n) {
+		auto buffer = std::array<Sample, Vector::Width>{};
+		store(buffer.data(), x);
+		std::memcpy(p, buffer.data(), n * sizeof(Sample));
+	}
+	inline auto operator+(Vector a, Vector b) { return Vector{ _mm256_add_ps(a.v, b.v) }; }
+	inline auto operator-(Vector a, Vector b) { return Vector{ _mm256_sub_ps(a.v, b.v) }; }
+	inline auto operator*(Vector a, Vector b) { return Vector{ _mm256_mul_ps(a.v, b.v) }; }
+	inline auto fmadd(Vector a, Vector b, Vector c) { return Vector{ _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+	inline auto min(Vector a, Vector b) { return Vector{ _mm256_min_ps(a.v, b.v) }; }
+	inline auto max(Vector a, Vector b) { return Vector{ _mm256_max_ps(a.v, b.v) }; }
+	inline auto abs(Vector a) { return Vector{ _mm256_and_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))) }; }
+	inline auto for_each_group = [](auto begin, auto end, auto group) {
+		auto vectorized = (end - begin) / Vector::Width * Vector::Width;
+		for (auto x : Range{ begin, begin + vectorized, Vector::Width })
+			group(x);
+		if (auto remaining = static_cast<int>(end - begin - vectorized); remaining > 0)
+			group(begin + vectorized, remaining);
+	};
+
+	struct Integer final {
+		__m256i v;
+	};
+	struct Mask final {
+		__m256i v;
+	};
+	inline auto broadcast(int x) { return Integer{ _mm256_set1_epi32(x) }; }
+	inline auto iota() { return Integer{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) }; }
+	inline auto to_integer(Vector x) { return Integer{ _mm256_cvtps_epi32(x.v) }; }
+	inline auto to_float(Integer x) { return Vector{ _mm256_cvtepi32_ps(x.v) }; }
+	inline auto operator+(Integer a, Integer b) { return Integer{ _mm256_add_epi32(a.v, b.v) }; }
+	inline auto operator-(Integer a, Integer b) { return Integer{ _mm256_sub_epi32(a.v, b.v) }; }
+	inline auto operator*(Integer a, Integer b) { return Integer{ _mm256_mullo_epi32(a.v, b.v) }; }
+	inline auto operator&(Integer a, Integer b) { return Integer{ _mm256_and_si256(a.v, b.v) }; }
+	inline auto operator<<(Integer a, int n) { return Integer{ _mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n)) }; }
+	inline auto operator>>(Integer a, int n) { return Integer{ _mm256_sra_epi32(a.v, _mm_cvtsi32_si128(n)) }; }
+	inline auto min(Integer a, Integer b) { return Integer{ _mm256_min_epi32(a.v, b.v) }; }
+	inline auto max(Integer a, Integer b) { return Integer{ _mm256_max_epi32(a.v, b.v) }; }
+	inline auto operator>(Integer a, Integer b) { return Mask{ _mm256_cmpgt_epi32(a.v, b.v) }; }
+	inline auto operator&(Mask a, Mask b) { return Mask{ _mm256_and_si256(a.v, b.v) }; }
+	inline auto select(Mask m, Integer a, Integer b) { return Integer{ _mm256_blendv_epi8(b.v, a.v, m.v) }; }
+	inline auto operator>>(Integer a, Integer n) { return Integer{ _mm256_srav_epi32(a.v, n.v) }; }
+	inline auto gather(const float* base, Integer index) { return Vector{ _mm256_i32gather_ps(base, index.v, 4) }; }
+	inline auto gather(const std::uint8_t* base, Integer index) { return Integer{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), index.v, 1) }; }
+	inline auto gather(const std::uint16_t* base, Integer index) { return Integer{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), index.v, 2) }; }
+	inline auto load(const int* p) { return Integer{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+	inline auto load(const int* p, int n) { return Integer{ _mm256_maskload_epi32(p, tail_mask(n)) }; }
+	inline auto store(int* p, Integer x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x.v); }
+	inline auto store(int* p, Integer x, int n) { _mm256_maskstore_epi32(p, tail_mask(n), x.v); }
+	inline auto gather(const int* base, Integer index) { return Integer{ _mm256_i32gather_epi32(base, index.v, 4) }; }
+}
+WARPSF_TARGET_END
+
+WARPSF_TARGET_BEGIN("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma")
+namespace AVX512 {
+	struct Vector final {
+		static constexpr auto Width = 16;
+		__m512 v;
+	};
+	inline auto tail_mask(int n) { return static_cast<__mmask16>((1u << n) - 1); }
+	inline auto broadcast(float x) { return Vector{ _mm512_set1_ps(x) }; }
+	inline auto load(const float* p) { return Vector{ _mm512_loadu_ps(p) }; }
+	inline auto load(const float* p, int n) { return Vector{ _mm512_maskz_loadu_ps(tail_mask(n), p) }; }
+	inline auto store(float* p, Vector x) { _mm512_storeu_ps(p, x.v); }
+	inline auto store(float* p, Vector x, int n) { _mm512_mask_storeu_ps(p, tail_mask(n), x.v); }
+	inline auto load(const std::uint8_t* p, int n = Vector::Width) { return Vector{ _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(tail_mask(n), p))) }; }
+	inline auto load(const std::uint16_t* p, int n = Vector::Width) { return Vector{ _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(tail_mask(n), p))) }; }
+	inline auto load(const Half* p, int n = Vector::Width) { return Vector{ _mm512_cvtph_ps(_mm256_maskz_loadu_epi16(tail_mask(n), p)) }; }
+	inline auto to_unsigned(Vector x) { return _mm512_max_epi32(_mm512_cvtps_epi32(x.v), _mm512_setzero_si512()); }
+	inline auto store(std::uint8_t* p, Vector x, int n = Vector::Width) { _mm512_mask_cvtusepi32_storeu_epi8(p, tail_mask(n), to_unsigned(x)); }
+	inline auto store(std::uint16_t* p, Vector x, int n = Vector::Width) { _mm512_mask_cvtusepi32_storeu_epi16(p, tail_mask(n), to_unsigned(x)); }
+	inline auto store(Half* p, Vector x, int n = Vector::Width) { _mm256_mask_storeu_epi16(p, tail_mask(n), _mm512_cvtps_ph(x.v, _MM_FROUND_TO_NEAREST_INT)); }
+	inline auto operator+(Vector a, Vector b) { return Vector{ _mm512_add_ps(a.v, b.v) }; }
+	inline auto operator-(Vector a, Vector b) { return Vector{ _mm512_sub_ps(a.v, b.v) }; }
+	inline auto operator*(Vector a, Vector b) { return Vector{ _mm512_mul_ps(a.v, b.v) }; }
+	inline auto fmadd(Vector a, Vector b, Vector c) { return Vector{ _mm512_fmadd_ps(a.v, b.v, c.v) }; }
+	inline auto min(Vector a, Vector b) { return Vector{ _mm512_min_ps(a.v, b.v) }; }
+	inline auto max(Vector a, Vector b) { return Vector{ _mm512_max_ps(a.v, b.v) }; }
+	inline auto abs(Vector a) { return Vector{ _mm512_abs_ps(a.v) }; }
+	inline auto for_each_group = [](auto begin, auto end, auto group) {
+		auto vectorized = (end - begin) / Vector::Width * Vector::Width;
+		for (auto x : Range{ begin, begin + vectorized, Vector::Width })
+			group(x);
+		if (auto remaining = static_cast<int>(end - begin - vectorized); remaining > 0)
+			group(begin + vectorized, remaining);
+	};
+
+	struct Integer final {
+		__m512i v;
+	};
+	struct Mask final {
+		__mmask16 v;
+	};
+	inline auto broadcast(int x) { return Integer{ _mm512_set1_epi32(x) }; }
+	inline auto iota() { return Integer{ _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15) }; }
+	inline auto to_integer(Vector x) { return Integer{ _mm512_cvtps_epi32(x.v) }; }
+	inline auto to_float(Integer x) { return Vector{ _mm512_cvtepi32_ps(x.v) }; }
+	inline auto operator+(Integer a, Integer b) { return Integer{ _mm512_add_epi32(a.v, b.v) }; }
+	inline auto operator-(Integer a, Integer b) { return Integer{ _mm512_sub_epi32(a.v, b.v) }; }
+	inline auto operator*(Integer a, Integer b) { return Integer{ _mm512_mullo_epi32(a.v, b.v) }; }
+	inline auto operator&(Integer a, Integer b) { return Integer{ _mm512_and_si512(a.v, b.v) }; }
+	inline auto operator<<(Integer a, int n) { return Integer{ _mm512_sll_epi32(a.v, _mm_cvtsi32_si128(n)) }; }
+	inline auto operator>>(Integer a, int n) { return Integer{ _mm512_sra_epi32(a.v, _mm_cvtsi32_si128(n)) }; }
+	inline auto min(Integer a, Integer b) { return Integer{ _mm512_min_epi32(a.v, b.v) }; }
+	inline auto max(Integer a, Integer b) { return Integer{ _mm512_max_epi32(a.v, b.v) }; }
+	inline auto operator>(Integer a, Integer b) { return Mask{ _mm512_cmpgt_epi32_mask(a.v, b.v) }; }
+	inline auto operator&(Mask a, Mask b) { return Mask{ static_cast<__mmask16>(a.v & b.v) }; }
+	inline auto select(Mask m, Integer a, Integer b) { return Integer{ _mm512_mask_blend_epi32(m.v, b.v, a.v) }; }
+	inline auto operator>>(Integer a, Integer n) { return Integer{ _mm512_srav_epi32(a.v, n.v) }; }
+	inline auto gather(const float* base, Integer index) { return Vector{ _mm512_i32gather_ps(index.v, base, 4) }; }
+	inline auto gather(const std::uint8_t* base, Integer index) { return Integer{ _mm512_i32gather_epi32(index.v, base, 1) }; }
+	inline auto gather(const std::uint16_t* base, Integer index) { return Integer{ _mm512_i32gather_epi32(index.v, base, 2) }; }
+	inline auto load(const int* p, int n = Vector::Width) { return Integer{ _mm512_maskz_loadu_epi32(tail_mask(n), p) }; }
+	inline auto store(int* p, Integer x, int n = Vector::Width) { _mm512_mask_storeu_epi32(p, tail_mask(n), x.v); }
+	inline auto gather(const int* base, Integer index) { return Integer{ _mm512_i32gather_epi32(index.v, base, 4) }; }
+}
+WARPSF_TARGET_END
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+}
\ No newline at end of file
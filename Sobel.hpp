@@ -0,0 +1,21 @@
+// included by Core.hpp once per instruction set, inside the matching namespace and target region.
+// integer sources are widened as they are loaded and the result scaled by 1 / peak, so the mask is always in [0, 1].
+
+inline auto sobel_row = [](auto above, auto center, auto below, auto dstp, auto width, auto thresh, auto peak) {
+	auto half = broadcast(.5f);
+	auto six = broadcast(static_cast<float>(6. / peak));
+	auto limit = broadcast(static_cast<float>(thresh));
+	auto avg = [=](auto middle, auto side1, auto side2) {
+		return fmadd(side1 + side2, half, middle) * half;
+	};
+	for_each_group(1, width - 1, [&](auto x, auto...tail) {
+		auto [up_left, up_center, up_right] = std::array{ load(above + x - 1, tail...), load(above + x, tail...), load(above + x + 1, tail...) };
+		auto [left, right] = std::array{ load(center + x - 1, tail...), load(center + x + 1, tail...) };
+		auto [down_left, down_center, down_right] = std::array{ load(below + x - 1, tail...), load(below + x, tail...), load(below + x + 1, tail...) };
+		auto abs_v = abs(avg(up_center, up_left, up_right) - avg(down_center, down_left, down_right));
+		auto abs_h = abs(avg(left, down_left, up_left) - avg(right, down_right, up_right));
+		store(dstp + x, min((abs_v + abs_h + max(abs_h, abs_v)) * six, limit), tail...);
+	});
+	dstp[0] = dstp[1];
+	dstp[width - 1] = dstp[width - 2];
+};
\ No newline at end of file
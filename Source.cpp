@@ -1,21 +1,113 @@
+#include "Core.hpp"
 #include "Cosmetics.hpp"
 #include "VapourSynth.h"
 #include "VSHelper.h"
+#include <list>
+
+using namespace warpsf;
+
+// the frames one request of a multi-output filter produced for its other outputs, kept until their own requests come
+// in. outputs of frames more than lag away from the one put on the shelf last are let go, as after a seek, and so are
+// the oldest while the shelf holds more than capacity bytes; they are produced again if they are asked for after all.
+class OutputShelf final {
+	struct Shelved final {
+		self(n, 0);
+		self(outputs, std::vector<const VSFrameRef*>{});
+	};
+	std::mutex mutex;
+	std::list<Shelved> frames;
+	self(api, static_cast<const VSAPI*>(nullptr));
+	self(capacity, 0_size);
+	self(lag, 0);
+	self(bytes, 0_size);
+	auto Bytes(const VSFrameRef* frame) {
+		auto total = 0_size;
+		for (auto plane : Range{ api->getFrameFormat(frame)->numPlanes })
+			total += static_cast<std::size_t>(api->getStride(frame, plane)) * api->getFrameHeight(frame, plane);
+		return total;
+	}
+	auto Release(Shelved& x) {
+		for (auto frame : x.outputs)
+			if (frame != nullptr) {
+				bytes -= Bytes(frame);
+				api->freeFrame(frame);
+			}
+		return true;
+	}
+public:
+	OutputShelf(const VSAPI* api, std::size_t capacity, int lag) {
+		this->api = api;
+		this->capacity = capacity;
+		this->lag = lag;
+	}
+	OutputShelf(OutputShelf&&) = delete;
+	OutputShelf(const OutputShelf&) = delete;
+	auto operator=(OutputShelf&&)->decltype(*this) = delete;
+	auto operator=(const OutputShelf&)->decltype(*this) = delete;
+	~OutputShelf() {
+		for (auto& x : frames)
+			Release(x);
+	}
+	// output index of frame n if it is on the shelf, handing over the reference, or nullptr.
+	auto Take(int n, int index) {
+		auto lock = std::lock_guard{ mutex };
+		auto frame = static_cast<const VSFrameRef*>(nullptr);
+		for (auto x = frames.begin(); x != frames.end(); ++x)
+			if (x->n == n) {
+				if (std::swap(frame, x->outputs[index]); frame != nullptr)
+					bytes -= Bytes(frame);
+				if (std::all_of(x->outputs.begin(), x->outputs.end(), [](auto output) { return output == nullptr; }))
+					frames.erase(x);
+				break;
+			}
+		return frame;
+	}
+	// keeps the references in outputs, null where an output was already returned, in place of any left for frame n.
+	auto Put(int n, std::vector<const VSFrameRef*> outputs) {
+		auto lock = std::lock_guard{ mutex };
+		frames.remove_if([&](auto& x) { return x.n == n && Release(x); });
+		for (auto frame : outputs)
+			if (frame != nullptr)
+				bytes += Bytes(frame);
+		frames.push_back({ n, std::move(outputs) });
+		frames.remove_if([&](auto& x) { return std::abs(x.n - n) > lag && Release(x); });
+		while (bytes > capacity && frames.empty() == false) {
+			Release(frames.front());
+			frames.pop_front();
+		}
+	}
+};
 
 struct FilterData final {
 	self(filterName, "");
+	self(filter, Filter::ASobel);
 	self(in, static_cast<const VSMap*>(nullptr));
 	self(out, static_cast<VSMap*>(nullptr));
 	self(api, static_cast<const VSAPI*>(nullptr));
+	self(core, static_cast<VSCore*>(nullptr));
 	self(node, static_cast<VSNodeRef*>(nullptr));
 	self(mask, static_cast<VSNodeRef*>(nullptr));
+	self(extra_sources, std::vector<VSNodeRef*>{});
 	self(vi, static_cast<const VSVideoInfo*>(nullptr));
+	self(output_vi, VSVideoInfo{});
 	self(thresh, 0.);
 	self(blur_type, 0ll);
 	self(blur_level, 0ll);
 	self(depth, std::array{ 0ll,0ll,0ll });
 	self(warpAlongLuma, false);
+	self(displaced, false);
+	self(subpixel_taps, 0);
+	self(mask_shift, 0);
 	self(process, std::array{ false,false,false });
+	self(isa, ISA::None);
+	self(tuning, Tuning{});
+	self(tune, false);
+	self(threads, 1ll);
+	self(single, true);
+	self(arena, std::shared_ptr<ScratchArena>{});
+	self(shelf, std::unique_ptr<OutputShelf>{});
+	self(collapse, false);
+	self(taps, std::vector<BlurTaps>(3));
 	FilterData() = default;
 	FilterData(FilterData&&) = default;
 	FilterData(const FilterData&) = default;
@@ -26,6 +118,18 @@ struct FilterData final {
 			api->freeNode(node);
 		if (mask != nullptr)
 			api->freeNode(mask);
+		for (auto x : extra_sources)
+			api->freeNode(x);
+	}
+	// AWarp with depth=0 on every plane it processes does not read its mask.
+	auto MaskUnused() const {
+		auto unused = displaced == false;
+		for (auto plane : Range{ 3 })
+			unused = unused && (process[plane] == false || depth[plane] == 0);
+		return unused;
+	}
+	auto Options() const {
+		return CoreOptions{ tuning, threads, single, arena.get() };
 	}
 	auto CheckFormat() {
 		auto errmsg = filterName + ": only single precision floating point, not RGB clips with constant format and dimensions supported."s;
@@ -35,6 +139,44 @@ struct FilterData final {
 		}
 		return true;
 	}
+	auto CheckSourceFormat() {
+		auto errmsg = filterName + ": only single precision floating point and 8 to 16 bit integer, not RGB clips with constant format and dimensions supported."s;
+		if (vi->format == nullptr || vi->width == 0 || vi->height == 0 || vi->format->colorFamily == cmRGB) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		if (auto bits = vi->format->bitsPerSample; vi->format->sampleType == stFloat ? bits != 32 : bits < 8 || bits > 16) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		return true;
+	}
+	auto CheckMaskFormat() {
+		auto errmsg = filterName + ": only 32 or 16 bit floating point and 8 to 16 bit integer masks, not RGB clips with constant format and dimensions supported."s;
+		if (vi->format == nullptr || vi->width == 0 || vi->height == 0 || vi->format->colorFamily == cmRGB) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		if (auto bits = vi->format->bitsPerSample; vi->format->sampleType == stFloat ? bits != 32 && bits != 16 : bits < 8 || bits > 16) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		return true;
+	}
+	auto CheckStorage() {
+		auto err = 0;
+		auto errmsg = filterName + ": storage must be between 0 and 3 (inclusive)."s;
+		auto storage = api->propGetInt(in, "storage", 0, &err);
+		if (err)
+			storage = 0;
+		if (storage < 0 || storage > 3) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		auto [sample_type, bits] = std::array<std::array<int, 2>, 4>{ { { stFloat, 32 }, { stFloat, 16 }, { stInteger, 8 }, { stInteger, 16 } } }[storage];
+		output_vi.format = api->registerFormat(vi->format->colorFamily, sample_type, bits, vi->format->subSamplingW, vi->format->subSamplingH, core);
+		return true;
+	}
 	auto CheckPlanes() {
 		auto n = vi->format->numPlanes;
 		auto m = std::max(api->propNumElements(in, "planes"), 0);
@@ -56,30 +198,64 @@ struct FilterData final {
 		}
 		return true;
 	}
-	auto InitializeSobel() {
-		filterName = "ASobel";
-		node = api->propGetNode(in, "clip", 0, nullptr);
-		vi = api->getVideoInfo(node);
+	auto CheckOpt() {
+		auto err = 0;
+		auto opt = api->propGetInt(in, "opt", 0, &err);
+		auto errmsg = filterName + ": opt must be between -1 and 4 (inclusive)."s;
+		if (err)
+			opt = 0;
+		if (opt < -1 || opt > 4) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		isa = opt <= 0 ? SupportedISA() : std::min(static_cast<ISA>(opt - 1), SupportedISA());
+		tuning = { isa, isa, isa, L2CacheBytes() };
+		tune = opt == -1;
+		return true;
+	}
+	auto CheckPrecision() {
 		auto err = 0;
+		auto errmsg = filterName + ": precision must be 0 or 1."s;
+		auto precision = api->propGetInt(in, "precision", 0, &err);
+		if (err)
+			precision = 0;
+		if (precision < 0 || precision > 1) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		single = precision == 0;
+		return true;
+	}
+	auto CheckThreads() {
+		auto err = 0;
+		auto errmsg = filterName + ": threads must be at least 0."s;
+		threads = api->propGetInt(in, "threads", 0, &err);
+		if (err)
+			threads = 1;
+		if (threads < 0) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		threads = threads == 0 ? ThreadPool::HardwareThreads() : std::min<long long>(threads, ThreadPool::HardwareThreads());
+		return true;
+	}
+	auto CheckThresh() {
+		auto err = 0;
+		auto errmsg = filterName + ": thresh must be between 0.0 and 256.0 (inclusive)."s;
 		thresh = api->propGetFloat(in, "thresh", 0, &err);
 		if (err)
 			thresh = 128.;
 		if (thresh < 0. || thresh > 256.) {
-			api->setError(out, "ASobel: thresh must be between 0.0 and 256.0 (inclusive).");
+			api->setError(out, errmsg.data());
 			return false;
 		}
 		thresh /= 256.;
-		if (auto format_status = CheckFormat(); format_status == false)
-			return false;
-		if (auto plane_status = CheckPlanes(); plane_status == false)
-			return false;
 		return true;
 	}
-	auto InitializeBlur() {
-		filterName = "ABlur";
-		node = api->propGetNode(in, "clip", 0, nullptr);
-		vi = api->getVideoInfo(node);
+	auto CheckBlur() {
 		auto err = 0;
+		auto errmsg1 = filterName + ": blur must be at least 0."s;
+		auto errmsg2 = filterName + ": type must be 0 or 1."s;
 		blur_type = api->propGetInt(in, "type", 0, &err);
 		if (err)
 			blur_type = 1;
@@ -87,26 +263,32 @@ struct FilterData final {
 		if (err)
 			blur_level = blur_type == 1 ? 3 : 2;
 		if (blur_level < 0) {
-			api->setError(out, "ABlur: blur must be at least 0.");
+			api->setError(out, errmsg1.data());
 			return false;
 		}
 		if (blur_type < 0 || blur_type > 1) {
-			api->setError(out, "ABlur: type must be 0 or 1.");
+			api->setError(out, errmsg2.data());
 			return false;
 		}
-		if (auto format_status = CheckFormat(); format_status == false)
-			return false;
-		if (auto plane_status = CheckPlanes(); plane_status == false)
+		return true;
+	}
+	auto CheckCollapse() {
+		auto err = 0;
+		auto errmsg = filterName + ": collapse must be 0 or 1."s;
+		auto mode = api->propGetInt(in, "collapse", 0, &err);
+		if (err)
+			mode = 0;
+		if (mode < 0 || mode > 1) {
+			api->setError(out, errmsg.data());
 			return false;
+		}
+		collapse = mode == 1;
 		return true;
 	}
-	auto InitializeWarp() {
-		filterName = "AWarp";
-		node = api->propGetNode(in, "clip", 0, nullptr);
-		mask = api->propGetNode(in, "mask", 0, nullptr);
-		vi = api->getVideoInfo(mask);
-		auto clipvi = api->getVideoInfo(node);
+	auto CheckDepth() {
 		auto err = 0;
+		auto errmsg1 = filterName + ": chroma must be 0 or 1."s;
+		auto errmsg2 = filterName + ": depth must be between -128 and 127 (inclusive)."s;
 		for (auto i : Range{ 3 }) {
 			depth[i] = api->propGetInt(in, "depth", i, &err);
 			if (err)
@@ -121,228 +303,307 @@ struct FilterData final {
 		if (err)
 			chroma = 0;
 		if (chroma < 0 || chroma > 1) {
-			api->setError(out, "AWarp: chroma must be 0 or 1.");
+			api->setError(out, errmsg1.data());
 			return false;
 		}
 		warpAlongLuma = chroma == 0;
 		for (auto x : depth)
 			if (x < -128 || x > 127) {
-				api->setError(out, "AWarp: depth must be between -128 and 127 (inclusive).");
+				api->setError(out, errmsg2.data());
 				return false;
 			}
-		if (auto format_status = CheckFormat(); format_status == false)
+		return true;
+	}
+	auto CheckDisplacementFormat() {
+		auto errmsg = filterName + ": displacement must be a clip made by ADisplacement."s;
+		if (vi->format == nullptr || vi->width == 0 || vi->height == 0 || vi->format->colorFamily == cmRGB || vi->format->sampleType != stInteger || vi->format->bitsPerSample != 16 || vi->height % 2 != 0) {
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		return true;
+	}
+	auto CheckUpsample() {
+		auto err = 0;
+		auto errmsg1 = filterName + ": upsample must be 1, 2 or 4."s;
+		auto errmsg2 = filterName + ": upsample needs mask."s;
+		auto upsample = api->propGetInt(in, "upsample", 0, &err);
+		if (err)
+			upsample = 1;
+		if (upsample != 1 && upsample != 2 && upsample != 4) {
+			api->setError(out, errmsg1.data());
+			return false;
+		}
+		if (upsample != 1 && displaced) {
+			api->setError(out, errmsg2.data());
+			return false;
+		}
+		mask_shift = upsample == 4 ? 2 : upsample == 2 ? 1 : 0;
+		output_vi.width <<= mask_shift;
+		output_vi.height <<= mask_shift;
+		return true;
+	}
+	auto CheckSubpixel(const VSVideoInfo* clipvi) {
+		auto err = 0;
+		auto errmsg1 = filterName + ": subpixel must be 0, 1 or 2."s;
+		auto errmsg2 = filterName + ": subpixel needs a clip of the same size as the output."s;
+		auto errmsg3 = filterName + ": subpixel needs every plane of clip to be at least 4 samples wide."s;
+		auto subpixel = api->propGetInt(in, "subpixel", 0, &err);
+		if (err)
+			subpixel = 0;
+		if (subpixel < 0 || subpixel > 2) {
+			api->setError(out, errmsg1.data());
 			return false;
+		}
+		subpixel_taps = subpixel == 0 ? 0 : static_cast<int>(subpixel) * 2;
+		if (subpixel_taps != 0 && clipvi->width != output_vi.width) {
+			api->setError(out, errmsg2.data());
+			return false;
+		}
+		if (subpixel_taps != 0 && clipvi->width >> clipvi->format->subSamplingW < 4) {
+			api->setError(out, errmsg3.data());
+			return false;
+		}
+		return true;
+	}
+	auto CheckSubsampling() {
+		auto errmsg = filterName + ": clip with subsampled chroma is not supported."s;
 		if (vi->format->subSamplingW > 0 || vi->format->subSamplingH > 0) {
-			api->setError(out, "AWarp: clip with subsampled chroma is not supported.");
+			api->setError(out, errmsg.data());
+			return false;
+		}
+		return true;
+	}
+	auto InitializeSobel() {
+		filterName = "ASobel";
+		filter = Filter::ASobel;
+		node = api->propGetNode(in, "clip", 0, nullptr);
+		vi = api->getVideoInfo(node);
+		output_vi = *vi;
+		if (auto thresh_status = CheckThresh(); thresh_status == false)
+			return false;
+		if (auto format_status = CheckSourceFormat(); format_status == false)
+			return false;
+		if (auto storage_status = CheckStorage(); storage_status == false)
+			return false;
+		if (auto plane_status = CheckPlanes(); plane_status == false)
+			return false;
+		if (auto opt_status = CheckOpt(); opt_status == false)
+			return false;
+		if (auto precision_status = CheckPrecision(); precision_status == false)
+			return false;
+		if (auto threads_status = CheckThreads(); threads_status == false)
+			return false;
+		return true;
+	}
+	auto InitializeBlur() {
+		filterName = "ABlur";
+		filter = Filter::ABlur;
+		node = api->propGetNode(in, "clip", 0, nullptr);
+		vi = api->getVideoInfo(node);
+		output_vi = *vi;
+		if (auto blur_status = CheckBlur(); blur_status == false)
+			return false;
+		if (auto collapse_status = CheckCollapse(); collapse_status == false)
+			return false;
+		if (auto format_status = CheckMaskFormat(); format_status == false)
+			return false;
+		if (auto plane_status = CheckPlanes(); plane_status == false)
+			return false;
+		if (auto opt_status = CheckOpt(); opt_status == false)
+			return false;
+		if (auto precision_status = CheckPrecision(); precision_status == false)
+			return false;
+		if (auto threads_status = CheckThreads(); threads_status == false)
+			return false;
+		if (collapse)
+			for (auto plane : Range{ 3 })
+				taps[plane] = collapse_blur(blur_type, plane == 0 ? blur_level : (blur_level + 1) / 2);
+		return true;
+	}
+	// the clips after the first in an array for AWarp, which are warped along the same mask into outputs of their own.
+	auto CheckSources(const VSVideoInfo* clipvi) {
+		for (auto index : Range{ 1, api->propNumElements(in, "clip") }) {
+			extra_sources.push_back(api->propGetNode(in, "clip", index, nullptr));
+			auto sourcevi = api->getVideoInfo(extra_sources.back());
+			if (sourcevi->format != clipvi->format || sourcevi->width != clipvi->width || sourcevi->height != clipvi->height) {
+				api->setError(out, "AWarp: every clip must have the format and dimensions of the first.");
+				return false;
+			}
+		}
+		return true;
+	}
+	auto InitializeWarp() {
+		filterName = "AWarp";
+		filter = Filter::AWarp;
+		auto err = 0;
+		node = api->propGetNode(in, "clip", 0, nullptr);
+		mask = api->propGetNode(in, "mask", 0, &err);
+		if (err) {
+			mask = api->propGetNode(in, "displacement", 0, &err);
+			displaced = err == 0;
+		}
+		else if (api->propNumElements(in, "displacement") > 0) {
+			api->setError(out, "AWarp: mask and displacement cannot be used together.");
+			return false;
+		}
+		if (mask == nullptr) {
+			api->setError(out, "AWarp: either mask or displacement is required.");
+			return false;
+		}
+		vi = api->getVideoInfo(node);
+		if (auto depth_status = CheckDepth(); depth_status == false)
+			return false;
+		if (auto format_status = CheckSourceFormat(); format_status == false)
+			return false;
+		auto clipvi = vi;
+		vi = api->getVideoInfo(mask);
+		output_vi = *vi;
+		output_vi.format = clipvi->format;
+		if (displaced) {
+			if (auto format_status = CheckDisplacementFormat(); format_status == false)
+				return false;
+			output_vi.height /= 2;
+			warpAlongLuma = false;
+		}
+		else if (auto format_status = CheckMaskFormat(); format_status == false)
+			return false;
+		if (auto upsample_status = CheckUpsample(); upsample_status == false)
+			return false;
+		if (auto supersampled = [&](auto factor) { return output_vi.width * factor == clipvi->width && output_vi.height * factor == clipvi->height; };
+			supersampled(1) == false && supersampled(2) == false && supersampled(4) == false && supersampled(8) == false) {
+			api->setError(out, "AWarp: clip must have the size of the output, mask times upsample, or 2, 4 or 8 times that size in each dimension.");
 			return false;
 		}
-		if (auto not_same_size = vi->width != clipvi->width || vi->height != clipvi->height, not_4x_size = vi->width * 4 != clipvi->width || vi->height * 4 != clipvi->height;
-			not_same_size && not_4x_size) {
-			api->setError(out, "AWarp: clip can either have the same size as mask, or four times the size of mask in each dimension.");
+		if (static_cast<long long>(clipvi->width) * clipvi->height >= 1ll << 30) {
+			api->setError(out, "AWarp: clip must have fewer than 2^30 samples per plane.");
 			return false;
 		}
-		if (vi->format != clipvi->format) {
-			api->setError(out, "AWarp: the two clips must have the same format.");
+		if (vi->format->colorFamily != clipvi->format->colorFamily) {
+			api->setError(out, "AWarp: the two clips must have the same color family.");
 			return false;
 		}
+		if (auto same_subsampling = vi->format->subSamplingW == clipvi->format->subSamplingW && vi->format->subSamplingH == clipvi->format->subSamplingH; warpAlongLuma == false && same_subsampling == false) {
+			api->setError(out, displaced ? "AWarp: displacement must have the same subsampling as clip." : "AWarp: the two clips must have the same subsampling when chroma=1.");
+			return false;
+		}
+		if (auto subpixel_status = CheckSubpixel(clipvi); subpixel_status == false)
+			return false;
+		if (auto sources_status = CheckSources(clipvi); sources_status == false)
+			return false;
 		if (auto plane_status = CheckPlanes(); plane_status == false)
 			return false;
+		if (auto opt_status = CheckOpt(); opt_status == false)
+			return false;
+		if (auto precision_status = CheckPrecision(); precision_status == false)
+			return false;
+		if (auto threads_status = CheckThreads(); threads_status == false)
+			return false;
+		return true;
+	}
+	auto InitializeDisplacement() {
+		filterName = "ADisplacement";
+		filter = Filter::ADisplacement;
+		node = api->propGetNode(in, "mask", 0, nullptr);
+		vi = api->getVideoInfo(node);
+		output_vi = *vi;
+		if (auto depth_status = CheckDepth(); depth_status == false)
+			return false;
+		if (auto format_status = CheckMaskFormat(); format_status == false)
+			return false;
+		if (auto opt_status = CheckOpt(); opt_status == false)
+			return false;
+		if (auto threads_status = CheckThreads(); threads_status == false)
+			return false;
+		output_vi.format = api->registerFormat(vi->format->colorFamily, stInteger, 16, vi->format->subSamplingW, vi->format->subSamplingH, core);
+		output_vi.height *= 2;
+		return true;
+	}
+	auto InitializeSharp() {
+		filterName = "AWarpSharp";
+		filter = Filter::AWarpSharp;
+		node = api->propGetNode(in, "clip", 0, nullptr);
+		vi = api->getVideoInfo(node);
+		output_vi = *vi;
+		if (auto thresh_status = CheckThresh(); thresh_status == false)
+			return false;
+		if (auto blur_status = CheckBlur(); blur_status == false)
+			return false;
+		if (auto depth_status = CheckDepth(); depth_status == false)
+			return false;
+		if (auto format_status = CheckFormat(); format_status == false)
+			return false;
+		if (auto subsampling_status = CheckSubsampling(); subsampling_status == false)
+			return false;
+		if (auto plane_status = CheckPlanes(); plane_status == false)
+			return false;
+		if (auto opt_status = CheckOpt(); opt_status == false)
+			return false;
+		if (auto precision_status = CheckPrecision(); precision_status == false)
+			return false;
+		if (auto threads_status = CheckThreads(); threads_status == false)
+			return false;
 		return true;
 	}
 };
 
-auto eval_multi = [](auto action, auto...params) {
-	auto results = std::array<double, sizeof...(params)>{};
-	auto cursor = results.data();
-	auto eval = [&](auto& ycomb, auto p, auto...rest) {
-		*cursor = action(p);
-		++cursor;
-		if constexpr (sizeof...(rest) != 0)
-			ycomb(ycomb, rest...);
-	};
-	if constexpr (sizeof...(params) != 0)
-		eval(eval, params...);
-	return results;
-};
-
-auto zip = [](auto...p) {
-	return eval_multi([](auto x) {return x; }, p...);
+auto format_samples = [](const VSFormat* format) {
+	return PlaneSamples{ format->sampleType == stFloat, format->bitsPerSample };
 };
 
-auto avg_multi = [](auto...pairs) {
-	return eval_multi([](auto x) {return (x[0] + x[1]) / 2.; }, pairs...);
+auto clip_format = [](const VSFormat* format) {
+	return ClipFormat{ format_samples(format), format->subSamplingW, format->subSamplingH };
 };
 
-auto sobel = [](auto srcp8, auto dstp8, auto stride, auto width, auto height, auto thresh) {
-	auto srcp = reinterpret_cast<const float*>(srcp8);
-	auto dstp = reinterpret_cast<float*>(dstp8);
-	auto dstp_orig = dstp;
-	stride /= sizeof(float);
-	srcp += stride;
-	dstp += stride;
-	for (auto _ : Range{ 1, height - 1 }) {
-		for (auto x : Range{ 1, width - 1 }) {
-			auto [avg_up, avg_down, avg_left, avg_right] = eval_multi(
-				[](auto x) {return (x[0] + (x[1] + x[2]) / 2.) / 2.; },
-				zip(srcp[x - stride], srcp[x - stride - 1], srcp[x - stride + 1]),
-				zip(srcp[x + stride], srcp[x + stride - 1], srcp[x + stride + 1]),
-				zip(srcp[x - 1], srcp[x + stride - 1], srcp[x - stride - 1]),
-				zip(srcp[x + 1], srcp[x + stride + 1], srcp[x - stride + 1]));
-			auto [abs_v, abs_h] = eval_multi([](auto x) {return std::abs(x); }, avg_up - avg_down, avg_left - avg_right);
-			auto abs_max = std::max(abs_h, abs_v);
-			dstp[x] = static_cast<float>(std::min((abs_v + abs_h + abs_max) * 6., thresh));
-		}
-		dstp[0] = dstp[1];
-		dstp[width - 1] = dstp[width - 2];
-		srcp += stride;
-		dstp += stride;
-	}
-	std::memcpy(dstp_orig, dstp_orig + stride, width * sizeof(float));
-	std::memcpy(dstp, dstp - stride, width * sizeof(float));
+// the planes of a frame as the core sees them. only the planes in use get data, so that planes a new frame shares
+// with its source are not made writable, which would copy them.
+auto frame_span = [](auto vsapi, auto frame, auto use, auto data) {
+	auto fmt = vsapi->getFrameFormat(frame);
+	auto span = FrameSpan<std::remove_pointer_t<decltype(data(0))>>{};
+	span.samples = format_samples(fmt);
+	span.ssw = fmt->subSamplingW;
+	span.ssh = fmt->subSamplingH;
+	for (auto plane : Range{ fmt->numPlanes })
+		span.planes[plane] = { use[plane] ? data(static_cast<int>(plane)) : nullptr, vsapi->getStride(frame, plane), vsapi->getFrameWidth(frame, plane), vsapi->getFrameHeight(frame, plane) };
+	return span;
 };
 
-auto blur_r6 = [](auto mask8, auto temp8, auto stride, auto width, auto height) {
-	auto mask = reinterpret_cast<float*>(mask8);
-	auto temp = reinterpret_cast<float*>(temp8);
-	stride /= sizeof(float);
-	auto partial_kernel = [](auto center, auto...pairs) {
-		auto [avg12, avg34, avg56] = avg_multi(pairs...);
-		auto [avg012, avg3456] = avg_multi(zip(center, avg12), zip(avg34, avg56));
-		auto [avg0123456] = avg_multi(zip(avg012, avg3456));
-		return static_cast<float>((avg012 + avg0123456) / 2.);
-	};
-	auto complete_kernel = [](auto center, auto...pairs) {
-		auto [avg11, avg22, avg33, avg44, avg55, avg66] = avg_multi(pairs...);
-		auto [avg12, avg34, avg56] = avg_multi(zip(avg11, avg22), zip(avg33, avg44), zip(avg55, avg66));
-		auto [avg012, avg3456] = avg_multi(zip(center, avg12), zip(avg34, avg56));
-		auto [avg0123456] = avg_multi(zip(avg012, avg3456));
-		return static_cast<float>((avg012 + avg0123456) / 2.);
-	};
-	auto blurH = [=]() mutable {
-		for (auto _ : Range{ height }) {
-			for (auto x : Range{ 6 })
-				temp[x] = partial_kernel(mask[x], zip(mask[x + 1], mask[x + 2]), zip(mask[x + 3], mask[x + 4]), zip(mask[x + 5], mask[x + 6]));
-			for (auto x : Range{ 6, width - 6 })
-				temp[x] = complete_kernel(mask[x], zip(mask[x - 1], mask[x + 1]), zip(mask[x - 2], mask[x + 2]), zip(mask[x - 3], mask[x + 3]),
-					zip(mask[x - 4], mask[x + 4]), zip(mask[x - 5], mask[x + 5]), zip(mask[x - 6], mask[x + 6]));
-			for (auto x : Range{ width - 6, width })
-				temp[x] = partial_kernel(mask[x], zip(mask[x - 1], mask[x - 2]), zip(mask[x - 3], mask[x - 4]), zip(mask[x - 5], mask[x - 6]));
-			mask += stride;
-			temp += stride;
-		}
-	};
-	auto blurV = [=]() mutable {
-		for (auto _ : Range{ 6 }) {
-			for (auto x : Range{ width })
-				mask[x] = partial_kernel(temp[x], zip(temp[x + stride], temp[x + stride * 2]), zip(temp[x + stride * 3], temp[x + stride * 4]), zip(temp[x + stride * 5], temp[x + stride * 6]));
-			mask += stride;
-			temp += stride;
-		}
-		for (auto _ : Range{ 6, height - 6 }) {
-			for (auto x : Range{ width })
-				mask[x] = complete_kernel(temp[x], zip(temp[x - stride], temp[x + stride]), zip(temp[x - stride * 2], temp[x + stride * 2]), zip(temp[x - stride * 3], temp[x + stride * 3]),
-					zip(temp[x - stride * 4], temp[x + stride * 4]), zip(temp[x - stride * 5], temp[x + stride * 5]), zip(temp[x - stride * 6], temp[x + stride * 6]));
-			mask += stride;
-			temp += stride;
-		}
-		for (auto _ : Range{ height - 6, height }) {
-			for (auto x : Range{ width })
-				mask[x] = partial_kernel(temp[x], zip(temp[x - stride], temp[x - stride * 2]), zip(temp[x - stride * 3], temp[x - stride * 4]), zip(temp[x - stride * 5], temp[x - stride * 6]));
-			mask += stride;
-			temp += stride;
-		}
-	};
-	blurH();
-	blurV();
+auto source_span = [](auto vsapi, auto frame) {
+	return frame_span(vsapi, frame, std::array{ true, true, true }, [&](auto plane) { return vsapi->getReadPtr(frame, plane); });
 };
 
-auto blur_r2 = [](auto mask8, auto temp8, auto stride, auto width, auto height) {
-	auto mask = reinterpret_cast<float*>(mask8);
-	auto temp = reinterpret_cast<float*>(temp8);
-	stride /= sizeof(float);
-	auto kernel = [](auto center, auto...pairs) {
-		auto [avg1, avg2] = avg_multi(pairs...);
-		auto avg = (avg2 + 3. * center) / 4.;
-		return static_cast<float>((avg + avg1) / 2.);
-	};
-	auto blurH = [=]() mutable {
-		for (auto _ : Range{ height }) {
-			temp[0] = kernel(mask[0], zip(mask[0], mask[1]), zip(mask[0], mask[2]));
-			temp[1] = kernel(mask[1], zip(mask[0], mask[2]), zip(mask[0], mask[3]));
-			for (auto x : Range{ 2, width - 2 })
-				temp[x] = kernel(mask[x], zip(mask[x - 1], mask[x + 1]), zip(mask[x - 2], mask[x + 2]));
-			temp[width - 2] = kernel(mask[width - 2], zip(mask[width - 3], mask[width - 1]), zip(mask[width - 4], mask[width - 1]));
-			temp[width - 1] = kernel(mask[width - 1], zip(mask[width - 2], mask[width - 1]), zip(mask[width - 3], mask[width - 1]));
-			mask += stride;
-			temp += stride;
-		}
-	};
-	auto blurV = [=]() mutable {
-		for (auto y : Range{ height }) {
-			auto stride_p1 = y > 0 ? -stride : 0;
-			auto stride_p2 = y > 1 ? stride_p1 * 2 : stride_p1;
-			auto stride_n1 = y < height - 1 ? stride : 0;
-			auto stride_n2 = y < height - 2 ? stride_n1 * 2 : stride_n1;
-			for (auto x : Range{ width })
-				mask[x] = kernel(temp[x], zip(temp[x + stride_p1], temp[x + stride_n1]), zip(temp[x + stride_p2], temp[x + stride_n2]));
-			mask += stride;
-			temp += stride;
-		}
-	};
-	blurH();
-	blurV();
+auto target_span = [](auto vsapi, auto frame, auto use) {
+	return frame_span(vsapi, frame, use, [&](auto plane) { return vsapi->getWritePtr(frame, plane); });
 };
 
-auto warp = [](auto srcp8, auto edgep8, auto dstp8, auto src_stride, auto edge_stride, auto dst_stride, auto width, auto height, auto depth, auto SMAGL) {
-	auto srcp = reinterpret_cast<const float*>(srcp8);
-	auto edgep = reinterpret_cast<const float*>(edgep8);
-	auto dstp = reinterpret_cast<float*>(dstp8);
-	auto SMAG = 1 << SMAGL;
-	auto x_limit_max = static_cast<long long>(width - 1)* SMAG;
-	src_stride /= sizeof(float);
-	edge_stride /= sizeof(float);
-	dst_stride /= sizeof(float);
-	depth <<= 8;
-	for (auto y : Range{ height }) {
-		for (auto x : Range{ width }) {
-			auto above = y == 0 ? edgep[x] : edgep[-edge_stride + x];
-			auto below = y == height - 1 ? edgep[x] : edgep[edge_stride + x];
-			auto left = x == 0 ? edgep[x] : edgep[x - 1];
-			auto right = x == width - 1 ? edgep[x] : edgep[x + 1];
-			auto calc_hv = [=](auto x) {
-				auto scaled = static_cast<long long>(nearbyintl(x * 256.));
-				scaled <<= 7;
-				scaled *= depth;
-				return scaled >> 16;
-			};
-			auto calc_remainder = [=](auto x) {
-				if (SMAGL != 0)
-					x <<= SMAGL;
-				return static_cast<double>(x & 127);
-			};
-			auto weighted_avg = [](auto x) {return (x[0] * (128. - x[2]) + x[1] * x[2]) / 128.; };
-			auto h = calc_hv(left - right), v = calc_hv(above - below);
-			v = std::min(std::max(v, -y * 128ll), (height - y) * 128ll - 129);
-			auto [remainder_h, remainder_v] = eval_multi(calc_remainder, h, v);
-			h >>= 7 - SMAGL;
-			v >>= 7 - SMAGL;
-			h += x << SMAGL;
-			if (auto remainder_needed = (x_limit_max > h) && !(h < 0); remainder_needed == false)
-				remainder_h = 0.;
-			h = std::max(std::min(h, x_limit_max), 0ll);
-			auto [s0, s1] = eval_multi(weighted_avg, zip(srcp[v * src_stride + h], srcp[v * src_stride + h + 1], remainder_h),
-				zip(srcp[(v + 1) * src_stride + h], srcp[(v + 1) * src_stride + h + 1], remainder_h));
-			dstp[x] = static_cast<float>(weighted_avg(zip(s0, s1, remainder_v)));
-		}
-		srcp += src_stride * SMAG;
-		edgep += edge_stride;
-		dstp += dst_stride;
+// the planes of the frames of a clip with their sizes and no data, for a frame that is never read.
+auto sized_span = [](const VSVideoInfo* vi) {
+	auto fmt = vi->format;
+	auto span = SourceFrame{};
+	span.samples = format_samples(fmt);
+	span.ssw = fmt->subSamplingW;
+	span.ssh = fmt->subSamplingH;
+	for (auto plane : Range{ fmt->numPlanes }) {
+		auto [ssw, ssh] = plane == 0 ? std::array{ 0, 0 } : std::array{ span.ssw, span.ssh };
+		span.planes[plane] = { nullptr, 0, vi->width >> ssw, vi->height >> ssh };
 	}
+	return span;
 };
 
 auto FilterInit = [](auto in, auto out, auto instanceData, auto node, auto core, auto vsapi) {
 	auto d = reinterpret_cast<FilterData*>(*instanceData);
-	vsapi->setVideoInfo(d->vi, 1, node);
+	auto outputs = std::vector(d->extra_sources.size() + 1, d->output_vi);
+	vsapi->setVideoInfo(outputs.data(), static_cast<int>(outputs.size()), node);
+	if (d->tune) {
+		auto SMAGL = 0;
+		if (d->filter == Filter::AWarp)
+			while (d->output_vi.width << SMAGL != vsapi->getVideoInfo(d->node)->width)
+				++SMAGL;
+		auto [tuning, tuned] = tune_kernels(d->tuning, d->filter, d->output_vi.width, d->output_vi.height, clip_format(d->vi->format), clip_format(d->output_vi.format),
+			d->blur_type, d->blur_level, SMAGL, d->subpixel_taps, d->displaced);
+		d->tuning = tuning;
+		auto message = d->filterName + ": tuned to"s + tuned + ".";
+		vsapi->logMessage(mtDebug, message.data());
+	}
 };
 
 auto aSobelGetFrame = [](auto n, auto activationReason, auto instanceData, auto frameData, auto frameCtx, auto core, auto vsapi) {
@@ -352,20 +613,18 @@ auto aSobelGetFrame = [](auto n, auto activationReason, auto instanceData, auto
 		vsapi->requestFrameFilter(n, d->node, frameCtx);
 	else if (activationReason == arAllFramesReady) {
 		auto src = vsapi->getFrameFilter(n, d->node, frameCtx);
+		auto fmt = vsapi->getFrameFormat(src);
+		auto converted = d->output_vi.format != fmt;
 		auto frames = std::array{
-			d->process[0] ? nullframe : src,
-			d->process[1] ? nullframe : src,
-			d->process[2] ? nullframe : src
+			d->process[0] || converted ? nullframe : src,
+			d->process[1] || converted ? nullframe : src,
+			d->process[2] || converted ? nullframe : src
 		};
 		auto planes = std::array{ 0, 1, 2 };
-		auto fmt = vsapi->getFrameFormat(src);
-		auto dst = vsapi->newVideoFrame2(fmt, vsapi->getFrameWidth(src, 0), vsapi->getFrameHeight(src, 0), frames.data(), planes.data(), src, core);
-		for (auto plane : Range{ fmt->numPlanes })
-			if (d->process[plane])
-				sobel(vsapi->getReadPtr(src, plane), vsapi->getWritePtr(dst, plane), vsapi->getStride(src, plane),
-					vsapi->getFrameWidth(src, plane), vsapi->getFrameHeight(src, plane), d->thresh);
-			else
-				continue;
+		auto dst = vsapi->newVideoFrame2(d->output_vi.format, vsapi->getFrameWidth(src, 0), vsapi->getFrameHeight(src, 0), frames.data(), planes.data(), src, core);
+		// planes that are not processed can only be shared with the source while the mask keeps its format.
+		auto written = converted ? std::array{ true, true, true } : d->process;
+		sobel_frame(d->Options(), source_span(vsapi, src), target_span(vsapi, dst, written), d->process, d->thresh);
 		vsapi->freeFrame(src);
 		return const_cast<decltype(nullframe)>(dst);
 	}
@@ -379,62 +638,118 @@ auto aBlurGetFrame = [](auto n, auto activationReason, auto instanceData, auto f
 		vsapi->requestFrameFilter(n, d->node, frameCtx);
 	else if (activationReason == arAllFramesReady) {
 		auto src = vsapi->getFrameFilter(n, d->node, frameCtx);
-		auto dst = vsapi->copyFrame(src, core);
-		auto fmt = vsapi->getFrameFormat(dst);
-		auto temp_stride = static_cast<std::size_t>(vsapi->getStride(dst, d->process[0] ? 0 : 1));
-		auto temp_height = vsapi->getFrameHeight(dst, d->process[0] ? 0 : 1);
-		auto temp = vs_aligned_malloc(temp_stride * temp_height, 32);
 		auto blur_level = std::array{ d->blur_level, (d->blur_level + 1) / 2, (d->blur_level + 1) / 2 };
+		// planes that are not blurred, either excluded or with no passes, are shared with src instead of copied, and
+		// the first pass of the others reads src directly.
+		auto blurred = std::array{ d->process[0] && blur_level[0] > 0, d->process[1] && blur_level[1] > 0, d->process[2] && blur_level[2] > 0 };
+		auto frames = std::array{
+			blurred[0] ? nullframe : src,
+			blurred[1] ? nullframe : src,
+			blurred[2] ? nullframe : src
+		};
+		auto planes = std::array{ 0, 1, 2 };
+		auto dst = vsapi->newVideoFrame2(vsapi->getFrameFormat(src), vsapi->getFrameWidth(src, 0), vsapi->getFrameHeight(src, 0), frames.data(), planes.data(), src, core);
+		blur_frame(d->Options(), source_span(vsapi, src), target_span(vsapi, dst, blurred), d->blur_type, blur_level, d->collapse ? &d->taps : nullptr);
 		vsapi->freeFrame(src);
-		for (auto plane : Range{ fmt->numPlanes })
-			if (d->process[plane])
-				for (auto _ : Range{ blur_level[plane] })
-					if (d->blur_type == 0)
-						blur_r6(vsapi->getWritePtr(dst, plane), temp, vsapi->getStride(dst, plane), vsapi->getFrameWidth(dst, plane), vsapi->getFrameHeight(dst, plane));
-					else
-						blur_r2(vsapi->getWritePtr(dst, plane), temp, vsapi->getStride(dst, plane), vsapi->getFrameWidth(dst, plane), vsapi->getFrameHeight(dst, plane));
-			else
-				continue;
-		vs_aligned_free(temp);
 		return const_cast<decltype(nullframe)>(dst);
 	}
 	return nullframe;
 };
 
+// an array of clips shares the mask frame and its gradients: the first request for a frame warps every clip along them
+// in one pass, returns the output it was made for and leaves the others on the shelf, where their own requests find
+// them before asking for any frames.
 auto aWarpGetFrame = [](auto n, auto activationReason, auto instanceData, auto frameData, auto frameCtx, auto core, auto vsapi) {
 	auto d = reinterpret_cast<const FilterData*>(*instanceData);
 	auto nullframe = static_cast<const VSFrameRef*>(nullptr);
+	auto nodes = std::vector{ d->node };
+	nodes.insert(nodes.end(), d->extra_sources.begin(), d->extra_sources.end());
 	if (activationReason == arInitial) {
+		if (auto shelved = d->shelf != nullptr ? d->shelf->Take(n, vsapi->getOutputIndex(frameCtx)) : nullframe; shelved != nullptr)
+			return shelved;
+		for (auto x : nodes)
+			vsapi->requestFrameFilter(n, x, frameCtx);
+		if (d->MaskUnused() == false)
+			vsapi->requestFrameFilter(n, d->mask, frameCtx);
+	}
+	else if (activationReason == arAllFramesReady) {
+		auto index = vsapi->getOutputIndex(frameCtx);
+		if (auto shelved = d->shelf != nullptr ? d->shelf->Take(n, index) : nullframe; shelved != nullptr)
+			return shelved;
+		auto srcs = std::vector<const VSFrameRef*>{};
+		for (auto x : nodes)
+			srcs.push_back(vsapi->getFrameFilter(n, x, frameCtx));
+		auto src = srcs[0];
+		auto mask = d->MaskUnused() ? nullframe : vsapi->getFrameFilter(n, d->mask, frameCtx);
+		auto mask_span = mask != nullptr ? source_span(vsapi, mask) : sized_span(d->vi);
+		auto SMAGL = 0;
+		auto src_width = vsapi->getFrameWidth(src, 0);
+		auto width = mask_span[0].width << d->mask_shift;
+		while (width << SMAGL != src_width)
+			++SMAGL;
+		auto warped = d->process;
+		auto planes = std::array{ 0, 1, 2 };
+		auto mask_height = mask_span[0].height;
+		auto dsts = std::vector<VSFrameRef*>{};
+		auto sources = std::vector<SourceFrame>{};
+		auto targets = std::vector<TargetFrame>{};
+		for (auto x : srcs) {
+			auto frames = std::array{
+				warped[0] || SMAGL != 0 ? nullframe : x,
+				warped[1] || SMAGL != 0 ? nullframe : x,
+				warped[2] || SMAGL != 0 ? nullframe : x
+			};
+			dsts.push_back(vsapi->newVideoFrame2(vsapi->getFrameFormat(x), width, d->displaced ? mask_height / 2 : mask_height << d->mask_shift, frames.data(), planes.data(), x, core));
+			sources.push_back(source_span(vsapi, x));
+			targets.push_back(target_span(vsapi, dsts.back(), warped));
+		}
+		warp_frames(d->Options(), sources, targets, mask_span, d->depth, d->warpAlongLuma, d->displaced, d->subpixel_taps, d->mask_shift);
+		for (auto x : srcs)
+			vsapi->freeFrame(x);
+		if (mask != nullptr)
+			vsapi->freeFrame(mask);
+		if (d->shelf == nullptr)
+			return const_cast<decltype(nullframe)>(dsts[0]);
+		auto outputs = std::vector<const VSFrameRef*>(dsts.begin(), dsts.end());
+		outputs[index] = nullptr;
+		d->shelf->Put(n, std::move(outputs));
+		return const_cast<decltype(nullframe)>(dsts[index]);
+	}
+	return nullframe;
+};
+
+auto aDisplacementGetFrame = [](auto n, auto activationReason, auto instanceData, auto frameData, auto frameCtx, auto core, auto vsapi) {
+	auto d = reinterpret_cast<const FilterData*>(*instanceData);
+	auto nullframe = static_cast<const VSFrameRef*>(nullptr);
+	if (activationReason == arInitial)
 		vsapi->requestFrameFilter(n, d->node, frameCtx);
-		vsapi->requestFrameFilter(n, d->mask, frameCtx);
+	else if (activationReason == arAllFramesReady) {
+		auto mask = vsapi->getFrameFilter(n, d->node, frameCtx);
+		auto dst = vsapi->newVideoFrame(d->output_vi.format, vsapi->getFrameWidth(mask, 0), vsapi->getFrameHeight(mask, 0) * 2, mask, core);
+		displacement_frame(d->Options(), source_span(vsapi, mask), target_span(vsapi, dst, std::array{ true, true, true }), d->depth, d->warpAlongLuma);
+		vsapi->freeFrame(mask);
+		return const_cast<decltype(nullframe)>(dst);
 	}
+	return nullframe;
+};
+
+auto aWarpSharpGetFrame = [](auto n, auto activationReason, auto instanceData, auto frameData, auto frameCtx, auto core, auto vsapi) {
+	auto d = reinterpret_cast<const FilterData*>(*instanceData);
+	auto nullframe = static_cast<const VSFrameRef*>(nullptr);
+	if (activationReason == arInitial)
+		vsapi->requestFrameFilter(n, d->node, frameCtx);
 	else if (activationReason == arAllFramesReady) {
 		auto src = vsapi->getFrameFilter(n, d->node, frameCtx);
-		auto mask = vsapi->getFrameFilter(n, d->mask, frameCtx);
-		auto SMAGL = 0;
+		auto warped = d->process;
 		auto frames = std::array{
-			d->process[0] ? nullframe : src,
-			d->process[1] ? nullframe : src,
-			d->process[2] ? nullframe : src
+			warped[0] ? nullframe : src,
+			warped[1] ? nullframe : src,
+			warped[2] ? nullframe : src
 		};
 		auto planes = std::array{ 0, 1, 2 };
-		auto fmt = vsapi->getFrameFormat(src);
-		auto src_width = vsapi->getFrameWidth(src, 0);
-		auto mask_width = vsapi->getFrameWidth(mask, 0);
-		if (mask_width != src_width) {
-			for (auto& x : frames)
-				x = nullframe;
-			SMAGL = 2;
-		}
-		auto dst = vsapi->newVideoFrame2(fmt, mask_width, vsapi->getFrameHeight(mask, 0), frames.data(), planes.data(), src, core);
-		for (auto plane : Range{ fmt->numPlanes })
-			if (d->process[plane])
-				warp(vsapi->getReadPtr(src, plane), vsapi->getReadPtr(mask, d->warpAlongLuma ? 0 : plane), vsapi->getWritePtr(dst, plane), vsapi->getStride(src, plane),
-					vsapi->getStride(mask, plane), vsapi->getStride(dst, plane), vsapi->getFrameWidth(dst, plane), vsapi->getFrameHeight(dst, plane), d->depth[plane], SMAGL);
-			else
-				continue;
+		auto dst = vsapi->newVideoFrame2(vsapi->getFrameFormat(src), vsapi->getFrameWidth(src, 0), vsapi->getFrameHeight(src, 0), frames.data(), planes.data(), src, core);
+		sharpen_frame(d->Options(), source_span(vsapi, src), target_span(vsapi, dst, warped), d->thresh, d->blur_type, d->blur_level, d->depth, d->warpAlongLuma);
 		vsapi->freeFrame(src);
-		vsapi->freeFrame(mask);
 		return const_cast<decltype(nullframe)>(dst);
 	}
 	return nullframe;
@@ -442,6 +757,11 @@ auto aWarpGetFrame = [](auto n, auto activationReason, auto instanceData, auto f
 
 auto FilterFree = [](auto instanceData, auto core, auto vsapi) {
 	auto d = reinterpret_cast<FilterData*>(instanceData);
+	if (d->arena != nullptr) {
+		auto message = d->filterName + ": peak footprint of the shared scratch arena "s + std::to_string(d->arena->PeakBytes()) + " bytes in " + std::to_string(d->arena->PeakBlocks()) + " blocks."s;
+		vsapi->logMessage(mtDebug, message.data());
+		d->arena = nullptr;
+	}
 	delete d;
 };
 
@@ -450,10 +770,12 @@ auto aSobelCreate = [](auto in, auto out, auto userData, auto core, auto vsapi)
 	d->in = in;
 	d->out = out;
 	d->api = vsapi;
+	d->core = core;
 	if (auto init_status = d->InitializeSobel(); init_status == false) {
 		delete d;
 		return;
 	}
+	d->arena = ScratchArena::Shared();
 	vsapi->createFilter(in, out, "ASobel", FilterInit, aSobelGetFrame, FilterFree, fmParallel, 0, d, core);
 };
 
@@ -466,6 +788,7 @@ auto aBlurCreate = [](auto in, auto out, auto userData, auto core, auto vsapi) {
 		delete d;
 		return;
 	}
+	d->arena = ScratchArena::Shared();
 	vsapi->createFilter(in, out, "ABlur", FilterInit, aBlurGetFrame, FilterFree, fmParallel, 0, d, core);
 };
 
@@ -478,27 +801,100 @@ auto aWarpCreate = [](auto in, auto out, auto userData, auto core, auto vsapi) {
 		delete d;
 		return;
 	}
+	d->arena = ScratchArena::Shared();
+	if (d->extra_sources.empty() == false) {
+		// room for the other outputs of as many frames as there are hardware threads, with rows padded to 64 bytes.
+		auto format = d->output_vi.format;
+		auto frame_bytes = 0_size;
+		for (auto plane : Range{ format->numPlanes }) {
+			auto [ssw, ssh] = plane == 0 ? std::array{ 0, 0 } : std::array{ format->subSamplingW, format->subSamplingH };
+			frame_bytes += static_cast<std::size_t>(((d->output_vi.width >> ssw) * format->bytesPerSample + 63) / 64 * 64) * (d->output_vi.height >> ssh);
+		}
+		auto threads = ThreadPool::HardwareThreads();
+		d->shelf = std::make_unique<OutputShelf>(vsapi, threads * d->extra_sources.size() * frame_bytes, static_cast<int>(2 * threads));
+	}
 	vsapi->createFilter(in, out, "AWarp", FilterInit, aWarpGetFrame, FilterFree, fmParallel, 0, d, core);
 };
 
+auto aDisplacementCreate = [](auto in, auto out, auto userData, auto core, auto vsapi) {
+	auto d = new FilterData{};
+	d->in = in;
+	d->out = out;
+	d->api = vsapi;
+	d->core = core;
+	if (auto init_status = d->InitializeDisplacement(); init_status == false) {
+		delete d;
+		return;
+	}
+	d->arena = ScratchArena::Shared();
+	vsapi->createFilter(in, out, "ADisplacement", FilterInit, aDisplacementGetFrame, FilterFree, fmParallel, 0, d, core);
+};
+
+auto aWarpSharpCreate = [](auto in, auto out, auto userData, auto core, auto vsapi) {
+	auto d = new FilterData{};
+	d->in = in;
+	d->out = out;
+	d->api = vsapi;
+	if (auto init_status = d->InitializeSharp(); init_status == false) {
+		delete d;
+		return;
+	}
+	d->arena = ScratchArena::Shared();
+	vsapi->createFilter(in, out, "AWarpSharp", FilterInit, aWarpSharpGetFrame, FilterFree, fmParallel, 0, d, core);
+};
+
 VS_EXTERNAL_API(auto) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc, VSPlugin* plugin) {
+	SupportedISA();
 	configFunc("com.zonked.awarpsharp2", "warpsf", "Warpsharp floating point version", VAPOURSYNTH_API_VERSION, 1, plugin);
 	registerFunc("ASobel",
 		"clip:clip;"
 		"thresh:float:opt;"
 		"planes:int[]:opt;"
+		"opt:int:opt;"
+		"precision:int:opt;"
+		"threads:int:opt;"
+		"storage:int:opt;"
 		, aSobelCreate, 0, plugin);
 	registerFunc("ABlur",
 		"clip:clip;"
 		"blur:int:opt;"
 		"type:int:opt;"
 		"planes:int[]:opt;"
+		"opt:int:opt;"
+		"precision:int:opt;"
+		"threads:int:opt;"
+		"collapse:int:opt;"
 		, aBlurCreate, 0, plugin);
 	registerFunc("AWarp",
-		"clip:clip;"
-		"mask:clip;"
+		"clip:clip[];"
+		"mask:clip:opt;"
 		"depth:int[]:opt;"
 		"chroma:int:opt;"
 		"planes:int[]:opt;"
+		"opt:int:opt;"
+		"precision:int:opt;"
+		"threads:int:opt;"
+		"displacement:clip:opt;"
+		"subpixel:int:opt;"
+		"upsample:int:opt;"
 		, aWarpCreate, 0, plugin);
+	registerFunc("ADisplacement",
+		"mask:clip;"
+		"depth:int[]:opt;"
+		"chroma:int:opt;"
+		"opt:int:opt;"
+		"threads:int:opt;"
+		, aDisplacementCreate, 0, plugin);
+	registerFunc("AWarpSharp",
+		"clip:clip;"
+		"thresh:float:opt;"
+		"blur:int:opt;"
+		"type:int:opt;"
+		"depth:int[]:opt;"
+		"chroma:int:opt;"
+		"planes:int[]:opt;"
+		"opt:int:opt;"
+		"precision:int:opt;"
+		"threads:int:opt;"
+		, aWarpSharpCreate, 0, plugin);
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include "Cosmetics.hpp"
+#include "SIMD.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace warpsf {
+
+// the instruction set each kernel family runs on and the cache budget that warp strips are sized for. opt sets every
+// family to one instruction set and the budget to the L2 size, opt=-1 has the tuner time them.
+struct Tuning final {
+	self(sobel, ISA::None);
+	self(blur, ISA::None);
+	self(warp, ISA::None);
+	self(cache_bytes, 0_size);
+};
+
+// the processor brand string, which tells apart CPUs that report the same instruction sets and cache sizes.
+inline auto CPUModel = []() {
+	auto model = "unknown"s;
+#ifdef WARPSF_X86
+	if (cpuid(0x80000000u, 0)[0] >= 0x80000004u) {
+		auto brand = std::array<char, 49>{};
+		for (auto leaf : Range{ 3 }) {
+			auto regs = cpuid(0x80000002u + static_cast<unsigned int>(leaf), 0);
+			std::memcpy(brand.data() + 16 * leaf, regs.data(), 16);
+		}
+		model = brand.data();
+		model.erase(0, model.find_first_not_of(' '));
+		model.erase(model.find_last_not_of(' ') + 1);
+	}
+#endif
+	return model;
+};
+
+// the fastest of 3 timed runs of body after a warm-up, in seconds.
+inline auto BestTime = [](auto body) {
+	auto best = 1e300;
+	body();
+	for ([[maybe_unused]] auto _ : Range{ 3 }) {
+		auto start = std::chrono::steady_clock::now();
+		body();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+};
+
+// tuned choices per kernel family and geometry, kept for the process and in a per user file, one line each of CPU
+// model, key, instruction set and cache budget separated by tabs. the file is $WARPSF_TUNING_CACHE, or
+// warpsf-tuning.txt in $XDG_CACHE_HOME, ~/.cache or %LOCALAPPDATA%; an empty $WARPSF_TUNING_CACHE keeps the choices
+// in memory only. lines of other CPUs are skipped, and the last line of a key wins, so processes that tune the same
+// key at once only append it twice.
+class TuningCache final {
+	using Choice = std::pair<ISA, std::size_t>;
+	std::mutex mutex;
+	std::map<std::string, Choice> choices;
+	self(model, CPUModel());
+	self(path, std::filesystem::path{});
+	TuningCache() {
+		auto variable = [](auto name) { auto value = std::getenv(name); return value == nullptr ? ""s : std::string{ value }; };
+		if (auto explicit_path = std::getenv("WARPSF_TUNING_CACHE"); explicit_path != nullptr)
+			path = explicit_path;
+		else if (auto xdg = variable("XDG_CACHE_HOME"); xdg.empty() == false)
+			path = std::filesystem::path{ xdg } / "warpsf-tuning.txt";
+		else if (auto home = variable("HOME"); home.empty() == false)
+			path = std::filesystem::path{ home } / ".cache" / "warpsf-tuning.txt";
+		else if (auto local = variable("LOCALAPPDATA"); local.empty() == false)
+			path = std::filesystem::path{ local } / "warpsf-tuning.txt";
+		if (path.empty())
+			return;
+		auto file = std::ifstream{ path };
+		for (auto line = ""s; std::getline(file, line);) {
+			auto fields = std::istringstream{ line };
+			auto [line_model, key, isa, cache_bytes] = std::array{ ""s, ""s, ""s, ""s };
+			std::getline(fields, line_model, '\t');
+			std::getline(fields, key, '\t');
+			std::getline(fields, isa, '\t');
+			std::getline(fields, cache_bytes, '\t');
+			if (line_model == model && key.empty() == false && isa.empty() == false && cache_bytes.empty() == false)
+				choices[key] = { std::min(static_cast<ISA>(std::strtol(isa.data(), nullptr, 10)), SupportedISA()), static_cast<std::size_t>(std::strtoull(cache_bytes.data(), nullptr, 10)) };
+		}
+	}
+public:
+	TuningCache(TuningCache&&) = delete;
+	TuningCache(const TuningCache&) = delete;
+	auto operator=(TuningCache&&)->decltype(*this) = delete;
+	auto operator=(const TuningCache&)->decltype(*this) = delete;
+	~TuningCache() = default;
+	static auto& Instance() {
+		static auto cache = TuningCache{};
+		return cache;
+	}
+	// the choice for key, from memory or the file, or tune() run once and recorded. tuning holds the lock, so filters
+	// created at the same time wait for one another instead of timing kernels against each other.
+	template<typename Tune>
+	auto Lookup(const std::string& key, Tune tune) {
+		auto lock = std::lock_guard{ mutex };
+		if (auto found = choices.find(key); found != choices.end())
+			return found->second;
+		auto choice = Choice{ tune() };
+		choices[key] = choice;
+		if (path.empty() == false) {
+			auto error = std::error_code{};
+			std::filesystem::create_directories(path.parent_path(), error);
+			auto file = std::ofstream{ path, std::ios::app };
+			file << model << '\t' << key << '\t' << static_cast<int>(choice.first) << '\t' << choice.second << '\n';
+		}
+		return choice;
+	}
+};
+}
\ No newline at end of file
@@ -0,0 +1,798 @@
+// randomized differential test of the single precision kernels against the double precision reference, built from the
+// plugin sources like the benchmark:
+//     g++ -std=c++17 -O2 -pthread Verify.cpp -o verify
+// "verify [rounds] [seed]" prints the largest absolute and ULP error of every kernel set and GetFrame path, and exits with 1
+// when an error is above the bound documented in README.md, a kernel writes outside its rows, or a GetFrame result changes
+// with threads, strides or the fused AWarpSharp path.
+#include "Source.cpp"
+#include "MockAPI.hpp"
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+
+// a plane with its own row stride in samples, often not a multiple of any vector width. the padding holds a sentinel, so
+// reads past the end of a row stay finite and writes past it can be detected.
+template<typename Sample = float>
+struct Plane final {
+	static constexpr auto sentinel = std::is_floating_point_v<Sample> ? static_cast<Sample>(1234.5f) : static_cast<Sample>(0xa5a5);
+	self(width, 0);
+	self(height, 0);
+	self(stride, 0);
+	self(data, std::vector<Sample>{});
+	Plane(int width, int height, int stride) {
+		this->width = width;
+		this->height = height;
+		this->stride = stride;
+		data.assign(static_cast<std::size_t>(stride) * height + 16, sentinel);
+	}
+	auto row(std::ptrdiff_t y) {
+		return data.data() + y * stride;
+	}
+	auto bytes() {
+		return reinterpret_cast<std::uint8_t*>(data.data());
+	}
+	// floats in [0, 1], integers in [0, peak].
+	auto Fill(std::mt19937& rng, int peak = 1) {
+		auto real = std::uniform_real_distribution<float>{ 0.f, 1.f };
+		auto integer = std::uniform_int_distribution<int>{ 0, peak };
+		for (auto y : Range{ height })
+			for (auto x : Range{ width })
+				if constexpr (std::is_floating_point_v<Sample>)
+					row(y)[x] = real(rng);
+				else
+					row(y)[x] = static_cast<Sample>(integer(rng));
+		return *this;
+	}
+	auto Intact() {
+		for (auto y : Range{ height })
+			for (auto x : Range{ width, stride })
+				if (row(y)[x] != sentinel)
+					return false;
+		for (auto x : Range{ static_cast<std::size_t>(stride) * height, data.size() })
+			if (data[x] != sentinel)
+				return false;
+		return true;
+	}
+};
+
+// maps floats onto integers that are consecutive for consecutive floats, so ULP distances are plain differences.
+auto ordered_bits = [](float x) {
+	auto bits = std::int32_t{};
+	std::memcpy(&bits, &x, sizeof(bits));
+	return bits < 0 ? static_cast<std::int64_t>(std::numeric_limits<std::int32_t>::min()) - bits : static_cast<std::int64_t>(bits);
+};
+
+struct Tally final {
+	self(cases, 0ll);
+	self(max_abs, 0.);
+	self(max_ulp, 0ll);
+	self(bound, 0.);
+	self(failures, 0ll);
+};
+
+class Checker final {
+	std::map<std::string, Tally> tallies;
+public:
+	auto Record(const std::string& check, double bound, bool passed) -> Tally& {
+		auto& tally = tallies[check];
+		tally.bound = std::max(tally.bound, bound);
+		++tally.cases;
+		if (passed == false)
+			++tally.failures;
+		return tally;
+	}
+	// reads width x height floats through row(y) from both sides and fails if any difference exceeds bound.
+	template<typename ExpectedRow, typename ActualRow>
+	auto Compare(const std::string& check, double bound, int width, int height, ExpectedRow expected, ActualRow actual, bool intact = true) {
+		auto max_abs = 0.;
+		auto max_ulp = 0ll;
+		for (auto y : Range{ height })
+			for (auto x : Range{ width }) {
+				auto [a, b] = std::array{ expected(y)[x], actual(y)[x] };
+				auto error = std::isnan(a) || std::isnan(b) ? std::numeric_limits<double>::infinity() : std::abs(static_cast<double>(a) - b);
+				max_abs = std::max(max_abs, error);
+				max_ulp = std::max<long long>(max_ulp, std::abs(ordered_bits(a) - ordered_bits(b)));
+			}
+		auto& tally = Record(check, bound, intact && max_abs <= bound);
+		tally.max_abs = std::max(tally.max_abs, max_abs);
+		tally.max_ulp = std::max(tally.max_ulp, max_ulp);
+	}
+	auto Report() {
+		auto failed = false;
+		std::printf("%-40s %8s %12s %10s %12s\n", "check", "cases", "max abs", "max ulp", "bound");
+		for (auto& [check, tally] : tallies) {
+			std::printf("%-40s %8lld %12.4g %10lld %12.4g%s\n", check.data(), tally.cases, tally.max_abs, tally.max_ulp, tally.bound, tally.failures != 0 ? "  FAILED" : "");
+			failed |= tally.failures != 0;
+		}
+		return failed;
+	}
+};
+
+// every single precision kernel set the CPU can run.
+auto kernel_sets = [](auto blur_type) {
+	auto sets = std::vector<std::pair<std::string, KernelSet>>{ { "scalar", select_kernels(ISA::None, blur_type, true) } };
+	for (auto [name, isa] : { std::pair{ "sse2", ISA::SSE2 }, std::pair{ "avx2", ISA::AVX2 }, std::pair{ "avx512", ISA::AVX512 } })
+		if (isa <= SupportedISA())
+			sets.emplace_back(name, select_kernels(isa, blur_type, true));
+	return sets;
+};
+
+int main(int argc, char** argv) {
+	auto rounds = argc > 1 ? std::stoi(argv[1]) : 200;
+	auto seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : std::random_device{}();
+	auto rng = std::mt19937{ seed };
+	auto uniform = [&](auto low, auto high) { return std::uniform_int_distribution<int>{ low, high }(rng); };
+	// a rectangle, across every column half the time, to be set to one value, zero half the time: the flat fills and
+	// letterbox bars that AWarp copies and ABlur clears instead of filtering them.
+	auto flat_area = [&](auto width, auto height) {
+		auto columns = std::array{ uniform(0, width), uniform(0, width) };
+		auto rows = std::array{ uniform(0, height), uniform(0, height) };
+		std::sort(columns.begin(), columns.end());
+		std::sort(rows.begin(), rows.end());
+		if (uniform(0, 1) == 0)
+			columns = { 0, width };
+		return std::array{ columns[0], columns[1], rows[0], rows[1] };
+	};
+	// the reference kernels are only defined down to these sizes: sobel needs 3 columns and rows, the radius 2 and 6
+	// blurs need 4 and 12 columns, and warp needs 2 rows.
+	auto random_width = [&](auto minimum) {
+		static constexpr auto vector_edges = std::array{ 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65 };
+		if (auto kind = uniform(0, 2); kind == 0)
+			return minimum + uniform(0, 24);
+		else if (kind == 1)
+			return std::max<int>(vector_edges[uniform(0, static_cast<int>(vector_edges.size()) - 1)], minimum);
+		else
+			return minimum + uniform(0, 700);
+	};
+	auto random_height = [&](auto minimum) {
+		return minimum + uniform(0, 40);
+	};
+	auto random_stride = [&](auto width) {
+		return width + uniform(0, 19);
+	};
+	auto checker = Checker{};
+	std::printf("seed %u, %d rounds\n", seed, rounds);
+
+	for (auto _ [[maybe_unused]] : Range{ rounds }) {
+		{
+			auto width = random_width(3);
+			auto height = random_height(3);
+			auto stride = random_stride(width);
+			auto thresh = std::uniform_real_distribution<double>{ 0., 1. }(rng);
+			auto src = Plane{ width, height, stride }.Fill(rng);
+			auto expected = Plane{ width, height, stride };
+			auto reference = select_kernels(ISA::None, 1ll, false);
+			auto samples = PlaneSamples{};
+			sobel_plane(reference, src.bytes(), expected.bytes(), stride * 4, stride * 4, width, height, 0, height, thresh, samples, samples, static_cast<float*>(nullptr));
+			for (auto& [name, kernels] : kernel_sets(1ll)) {
+				auto actual = Plane{ width, height, stride };
+				sobel_plane(kernels, src.bytes(), actual.bytes(), stride * 4, stride * 4, width, height, 0, height, thresh, samples, samples, static_cast<float*>(nullptr));
+				checker.Compare("kernel sobel " + name, std::ldexp(1., -19), width, height,
+					[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+			}
+		}
+		for (auto blur_type : { 0ll, 1ll }) {
+			auto width = random_width(blur_type == 0 ? 12 : 4);
+			auto height = random_height(1);
+			auto stride = random_stride(width);
+			auto blur_level = static_cast<long long>(uniform(0, 3));
+			auto src = Plane{ width, height, stride }.Fill(rng);
+			auto blur_band = [&](auto& kernels, auto passes, auto& dst, auto first, auto last) {
+				auto buffer = std::vector<float>(blur_stream_rows(kernels, passes) * scratch_stride(width));
+				blur_stream(kernels, width, height, first, last, passes, buffer.data(), scratch_stride(width),
+					[&](auto y, auto) { return static_cast<const float*>(src.row(y)); },
+					[&](auto y) { return dst.row(y); },
+					[](auto) {});
+			};
+			auto blur = [&](auto& kernels, auto passes, auto& dst) {
+				blur_band(kernels, passes, dst, 0, height);
+			};
+			auto expected = Plane{ width, height, stride };
+			auto reference = select_kernels(ISA::None, blur_type, false);
+			blur(reference, blur_level, expected);
+			auto prefix = "kernel blur_r"s + (blur_type == 0 ? "6 " : "2 ");
+			for (auto& [name, kernels] : kernel_sets(blur_type)) {
+				auto actual = Plane{ width, height, stride };
+				blur(kernels, blur_level, actual);
+				checker.Compare(prefix + name, blur_level * std::ldexp(1., -22), width, height,
+					[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+				// the same plane in random row bands, as GetFrame splits it across threads, must not change a bit.
+				auto banded = Plane{ width, height, stride };
+				for (auto first = 0; first < height;) {
+					auto last = std::min(first + uniform(1, 24), height);
+					blur_band(kernels, blur_level, banded, first, last);
+					first = last;
+				}
+				checker.Compare(prefix + name + " bands", 0., width, height,
+					[&](auto y) { return actual.row(y); }, [&](auto y) { return banded.row(y); }, banded.Intact());
+			}
+			auto taps = collapse_blur(blur_type, blur_level);
+			if (blur_level == 0 || std::min(width, height) <= 2 * taps.radius)
+				continue;
+			auto collapsed_sets = kernel_sets(blur_type);
+			collapsed_sets.emplace_back("reference", reference);
+			for (auto& [name, kernels] : collapsed_sets) {
+				auto actual = Plane{ width, height, stride };
+				auto collapsed = CollapsedBlur{ &kernels, &taps, taps.radius };
+				blur(collapsed, 1ll, actual);
+				checker.Compare(prefix + "collapsed " + name, std::ldexp(1., -22), width, height,
+					[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+			}
+		}
+		for (auto SMAGL : { 0, 1, 2, 3 }) {
+			// half the planes are chroma warped along a luma mask with 4:2:0, 4:2:2 or 4:4:0 subsampling.
+			auto width = random_width(1);
+			auto height = random_height(2);
+			auto depth = static_cast<long long>(uniform(-128, 127));
+			auto subsampled = uniform(0, 1) == 1;
+			auto ssw = subsampled ? uniform(0, 1) : 0;
+			auto ssh = subsampled ? uniform(ssw == 0 ? 1 : 0, 1) : 0;
+			auto mask = Plane{ width << ssw, height << ssh, random_stride(width << ssw) }.Fill(rng);
+			auto [left, right, top, bottom] = flat_area(width << ssw, height << ssh);
+			auto level = uniform(0, 1) == 0 ? 0.f : mask.row(0)[0];
+			for (auto y : Range{ top, bottom, 1 })
+				std::fill(mask.row(y) + left, mask.row(y) + right, level);
+			auto src = Plane{ width << SMAGL, height << SMAGL, random_stride(width << SMAGL) }.Fill(rng);
+			auto dst_stride = random_stride(width);
+			auto warp = [&](auto& kernels, auto& dst) {
+				auto samples = PlaneSamples{};
+				warp_plane(kernels, src.bytes(), mask.bytes(), dst.bytes(), src.stride * 4, mask.stride * 4, dst.stride * 4, width, height, 0, height, depth, SMAGL, ssw, ssh, samples, samples, static_cast<float*>(nullptr), 0);
+			};
+			auto expected = Plane{ width, height, dst_stride };
+			auto reference = select_kernels(ISA::None, 1ll, false);
+			warp(reference, expected);
+			for (auto& [name, kernels] : kernel_sets(1ll)) {
+				auto actual = Plane{ width, height, dst_stride };
+				warp(kernels, actual);
+				checker.Compare("kernel warp smagl " + std::to_string(SMAGL) + (subsampled ? " subsampled " : " ") + name, std::ldexp(1., -22), width, height,
+					[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+				// gradients shared across planes have to give exactly the displacement computed straight from the mask.
+				auto shared = Plane{ width, height, dst_stride };
+				auto targets = std::array{ WarpTarget{ src.bytes(), shared.bytes(), src.stride * 4, dst_stride * 4, width, height, depth, ssw, ssh } };
+				auto row_stride = scratch_stride(width << ssw);
+				auto scratch = std::vector<float>(warp_scratch_rows() * row_stride);
+				auto samples = PlaneSamples{};
+				warp_targets(kernels, targets, mask.bytes(), mask.stride * 4, width << ssw, height << ssh, 0, 0, height << ssh, SMAGL, 0, samples, samples, scratch.data(), row_stride, L2CacheBytes());
+				checker.Compare("kernel warp shared gradients smagl " + std::to_string(SMAGL) + (subsampled ? " subsampled " : " ") + name, 0., width, height,
+					[&](auto y) { return actual.row(y); }, [&](auto y) { return shared.row(y); }, shared.Intact());
+				// no cache at all forces strips of 64 columns, and a band boundary off the block grid.
+				auto tiled = Plane{ width, height, dst_stride };
+				targets[0].dstp8 = tiled.bytes();
+				auto split = uniform(0, height) << ssh;
+				warp_targets(kernels, targets, mask.bytes(), mask.stride * 4, width << ssw, height << ssh, 0, 0, split, SMAGL, 0, samples, samples, scratch.data(), row_stride, 0);
+				warp_targets(kernels, targets, mask.bytes(), mask.stride * 4, width << ssw, height << ssh, 0, split, height << ssh, SMAGL, 0, samples, samples, scratch.data(), row_stride, 0);
+				checker.Compare("kernel warp tiled smagl " + std::to_string(SMAGL) + (subsampled ? " subsampled " : " ") + name, 0., width, height,
+					[&](auto y) { return actual.row(y); }, [&](auto y) { return tiled.row(y); }, tiled.Intact());
+			}
+		}
+		{
+			// the gradients of a mask 2 or 4 times smaller than the plane, upsampled in two bands, against the bilinear
+			// interpolation of the reference gradients between centred mask samples, divided by the factor and rounded.
+			auto mask_shift = uniform(1, 2);
+			auto scale = 1 << mask_shift;
+			auto mask_width = random_width(1);
+			auto mask_height = random_height(1);
+			auto [width, height] = std::array{ mask_width << mask_shift, mask_height << mask_shift };
+			auto mask = Plane{ mask_width, mask_height, random_stride(mask_width) }.Fill(rng);
+			auto reference = select_kernels(ISA::None, 1ll, false);
+			auto mask_gradients = std::vector<std::vector<int>>(2 * mask_height, std::vector<int>(mask_width));
+			for (auto y : Range{ mask_height })
+				reference.gradient_row(mask.row(clamp_row(y - 1, mask_height)), mask.row(y), mask.row(clamp_row(y + 1, mask_height)), mask_gradients[2 * y].data(), mask_gradients[2 * y + 1].data(), mask_width);
+			auto expected = std::vector<std::vector<int>>(2 * height, std::vector<int>(width));
+			auto around = [&](auto i, auto size) {
+				auto position = (i + .5) / scale - .5;
+				auto lower = std::floor(position);
+				return std::tuple{ clamp_row(static_cast<std::ptrdiff_t>(lower), size), clamp_row(static_cast<std::ptrdiff_t>(lower) + 1, size), position - lower };
+			};
+			for (auto y : Range{ height })
+				for (auto x : Range{ width }) {
+					auto [above, below, weight_v] = around(y, mask_height);
+					auto [left, right, weight_h] = around(x, mask_width);
+					for (auto component : Range{ 2 }) {
+						auto value = [&](auto row, auto column) { return static_cast<double>(mask_gradients[2 * row + component][column]); };
+						auto upper = value(above, left) * (1. - weight_h) + value(above, right) * weight_h;
+						auto lower = value(below, left) * (1. - weight_h) + value(below, right) * weight_h;
+						expected[2 * y + component][x] = static_cast<int>(std::floor((upper * (1. - weight_v) + lower * weight_v) / scale + .5));
+					}
+				}
+			for (auto& [name, kernels] : kernel_sets(1ll)) {
+				auto actual = std::vector<std::vector<int>>(2 * height, std::vector<int>(width));
+				auto row_stride = scratch_stride(width);
+				auto scratch = std::vector<float>(warp_scratch_rows() * row_stride);
+				auto samples = PlaneSamples{};
+				auto split = uniform(0, height);
+				for (auto [first, last] : { std::array{ 0, split }, std::array{ split, height } })
+					upsampled_gradient_rows(kernels, samples, mask.bytes(), mask.stride * 4, mask_width, mask_height, mask_shift, first, last, scratch.data(), row_stride, 1, [&](auto gradient_h, auto gradient_v, auto row) {
+						std::copy(gradient_h, gradient_h + width, actual[2 * row].data());
+						std::copy(gradient_v, gradient_v + width, actual[2 * row + 1].data());
+					});
+				checker.Compare("kernel upsample gradients " + std::to_string(scale) + "x " + name, 0., width, 2 * height,
+					[&](auto y) { return expected[y].data(); }, [&](auto y) { return actual[y].data(); });
+			}
+		}
+		for (auto bits : { 8, 10, 16 }) {
+			// integer sources are interpolated exactly, so every kernel set has to match the rounded reference.
+			auto SMAGL = uniform(0, 3);
+			auto width = random_width(1);
+			auto height = random_height(2);
+			auto depth = static_cast<long long>(uniform(-128, 127));
+			auto mask = Plane{ width, height, random_stride(width) }.Fill(rng);
+			auto source = PlaneSamples{};
+			source.storage = bits == 8 ? Storage::Byte : Storage::Word;
+			source.peak = static_cast<float>((1 << bits) - 1);
+			auto samples = PlaneSamples{};
+			auto check = [&](auto sample) {
+				using Sample = decltype(sample);
+				auto src = Plane<Sample>{ width << SMAGL, height << SMAGL, random_stride(width << SMAGL) }.Fill(rng, (1 << bits) - 1);
+				auto dst_stride = random_stride(width);
+				auto warp = [&](auto& kernels, auto& dst) {
+					warp_plane(kernels, src.bytes(), mask.bytes(), dst.bytes(), src.stride * static_cast<int>(sizeof(Sample)), mask.stride * 4, dst.stride * static_cast<int>(sizeof(Sample)),
+						width, height, 0, height, depth, SMAGL, 0, 0, source, samples, static_cast<float*>(nullptr), 0);
+				};
+				auto expected = Plane<Sample>{ width, height, dst_stride };
+				auto reference = select_kernels(ISA::None, 1ll, false);
+				warp(reference, expected);
+				for (auto& [name, kernels] : kernel_sets(1ll)) {
+					auto actual = Plane<Sample>{ width, height, dst_stride };
+					warp(kernels, actual);
+					checker.Compare("kernel warp " + std::to_string(bits) + " bit smagl " + std::to_string(SMAGL) + " " + name, 0., width, height,
+						[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+				}
+			};
+			if (bits == 8)
+				check(std::uint8_t{});
+			else
+				check(std::uint16_t{});
+		}
+		{
+			// mask values and exact rounding ties of every integer storage, narrowed and widened again by each kernel set.
+			auto width = random_width(1);
+			auto values = Plane{ width, 1, width }.Fill(rng);
+			for (auto x : Range{ width })
+				if (uniform(0, 3) == 0)
+					values.row(0)[x] = (uniform(0, 254) + .5f) / (uniform(0, 1) == 0 ? 255.f : 65535.f);
+			auto round_trip = [&](auto& kernels, auto sample, auto narrow, auto widen, auto scale) {
+				auto stored = std::vector<decltype(sample)>(width);
+				auto restored = Plane{ width, 1, width };
+				(kernels.*narrow)(values.row(0), stored.data(), width, scale);
+				(kernels.*widen)(stored.data(), restored.row(0), width, 1.f / scale);
+				return restored;
+			};
+			auto check = [&](auto name, auto sample, auto narrow, auto widen, auto scale, auto quantization) {
+				auto reference = select_kernels(ISA::None, 1ll, false);
+				auto expected = round_trip(reference, sample, narrow, widen, scale);
+				checker.Compare("kernel convert "s + name + " quantization", quantization, width, 1,
+					[&](auto y) { return values.row(y); }, [&](auto y) { return expected.row(y); });
+				for (auto& [set, kernels] : kernel_sets(1ll)) {
+					auto actual = round_trip(kernels, sample, narrow, widen, scale);
+					checker.Compare("kernel convert "s + name + " " + set, 0., width, 1,
+						[&](auto y) { return expected.row(y); }, [&](auto y) { return actual.row(y); }, actual.Intact());
+				}
+			};
+			check("half", Half{}, &KernelSet::narrow_half, &KernelSet::widen_half, 1.f, std::ldexp(1., -12));
+			check("byte", std::uint8_t{}, &KernelSet::narrow_byte, &KernelSet::widen_byte, 255.f, .5 / 255. + 1e-7);
+			check("word", std::uint16_t{}, &KernelSet::narrow_word, &KernelSet::widen_word, 65535.f, .5 / 65535. + 1e-7);
+		}
+	}
+
+	// the full filters through the mock core: every opt with precision=0 against precision=1, the same result for any
+	// threads and stride padding, AWarpSharp against AWarp(ABlur(ASobel)) with the same settings, and compact masks
+	// against single precision masks holding the same values. opt=-1 mixes the kernel sets the tuner picks, which are
+	// kept in memory rather than in the tuning cache of the user.
+	setenv("WARPSF_TUNING_CACHE", "", 1);
+	auto& mock = MockCore::Instance();
+	auto formats = std::array{ mock.Format(cmGray, stFloat, 32), mock.Format(cmYUV, stFloat, 32) };
+	auto options = std::vector<long long>{ -1, 1 };
+	for (auto isa : { ISA::SSE2, ISA::AVX2, ISA::AVX512 })
+		if (isa <= SupportedISA())
+			options.push_back(static_cast<long long>(isa) + 1);
+	for (auto _ [[maybe_unused]] : Range{ std::max(rounds / 10, 1) }) {
+		auto format = formats[uniform(0, 1)];
+		auto width = uniform(16, 160);
+		auto height = uniform(16, 96);
+		auto integer_format = mock.Format(format->colorFamily, stInteger, std::array{ 8, 10, 16 }[uniform(0, 2)]);
+		auto random_source = [&](auto source_format, auto source_width, auto source_height) {
+			auto values = std::uniform_real_distribution<float>{ 0.f, 1.f };
+			auto peak = (1 << source_format->bitsPerSample) - 1;
+			return mock.Source(source_format, source_width, source_height, 1, [&](auto frame) {
+				for (auto plane : Range{ source_format->numPlanes }) {
+					auto [left, right, top, bottom] = flat_area(frame->width[plane], frame->height[plane]);
+					auto flat = uniform(0, 1) == 0;
+					auto level = uniform(0, 1) == 0 ? 0. : values(rng);
+					for (auto y : Range{ frame->height[plane] }) {
+						auto row = frame->planes[plane].get() + y * frame->stride[plane];
+						for (auto x : Range{ frame->stride[plane] / source_format->bytesPerSample }) {
+							auto value = flat && y >= top && y < bottom && x >= left && x < right ? level : values(rng);
+							if (source_format->sampleType == stFloat)
+								reinterpret_cast<float*>(row)[x] = static_cast<float>(value);
+							else if (source_format->bytesPerSample == 1)
+								row[x] = static_cast<std::uint8_t>(std::lround(value * peak));
+							else
+								reinterpret_cast<std::uint16_t*>(row)[x] = static_cast<std::uint16_t>(std::lround(value * peak));
+						}
+					}
+				}
+			});
+		};
+		auto clip = random_source(format, width, height);
+		auto mask = random_source(format, width, height);
+		auto integer_clip = random_source(integer_format, width, height);
+		auto thresh = std::uniform_real_distribution<double>{ 0., 256. }(rng);
+		auto blur_type = static_cast<std::int64_t>(uniform(0, 1));
+		auto blur_level = static_cast<std::int64_t>(uniform(0, 3));
+		auto depth = std::array{ static_cast<std::int64_t>(uniform(-128, 127)), static_cast<std::int64_t>(uniform(-128, 127)), static_cast<std::int64_t>(uniform(-128, 127)) };
+		if (uniform(0, 3) == 0)
+			depth[uniform(0, 2)] = 0;
+		auto chroma = static_cast<std::int64_t>(uniform(0, 1));
+		auto collapse = static_cast<std::int64_t>(uniform(0, 1));
+		auto factor = 1 << uniform(0, 3);
+		auto factor_name = factor == 1 ? ""s : " " + std::to_string(factor) + "x";
+		auto upsampled = factor == 1 ? clip : random_source(format, width * factor, height * factor);
+		auto integer_upsampled = factor == 1 ? integer_clip : random_source(integer_format, width * factor, height * factor);
+		auto padding = 4 * uniform(1, 15);
+		auto render = [&](auto name, auto configure, auto opt, auto precision, auto threads, auto stride_padding) {
+			mock.SetStridePadding(stride_padding);
+			auto args = VSMap{};
+			configure(args);
+			MockCore::Arg(args, "opt", std::int64_t{ opt });
+			MockCore::Arg(args, "precision", std::int64_t{ precision });
+			MockCore::Arg(args, "threads", std::int64_t{ threads });
+			auto out = mock.Invoke(name, args);
+			if (out.error.empty() == false) {
+				std::cerr << out.error << std::endl;
+				std::exit(1);
+			}
+			auto frame = mock.GetFrame(MockCore::Clip(out), 0);
+			mock.SetStridePadding(0);
+			return frame;
+		};
+		auto sobel_args = [&](auto& args) {
+			MockCore::Arg(args, "clip", clip);
+			MockCore::Arg(args, "thresh", thresh);
+		};
+		auto integer_sobel_args = [&](auto& args) {
+			MockCore::Arg(args, "clip", integer_clip);
+			MockCore::Arg(args, "thresh", thresh);
+		};
+		auto blur_args = [&](auto source, auto collapsed) {
+			return [&, source, collapsed](auto& args) {
+				MockCore::Arg(args, "clip", source);
+				MockCore::Arg(args, "type", blur_type);
+				MockCore::Arg(args, "blur", blur_level);
+				MockCore::Arg(args, "collapse", collapsed);
+			};
+		};
+		auto warp_args = [&](auto source, auto edges) {
+			return [&, source, edges](auto& args) {
+				MockCore::Arg(args, "clip", source);
+				MockCore::Arg(args, "mask", edges);
+				for (auto x : depth)
+					MockCore::Arg(args, "depth", x);
+				MockCore::Arg(args, "chroma", chroma);
+			};
+		};
+		auto sharp_args = [&](auto& args) {
+			MockCore::Arg(args, "clip", clip);
+			MockCore::Arg(args, "thresh", thresh);
+			MockCore::Arg(args, "type", blur_type);
+			MockCore::Arg(args, "blur", blur_level);
+			for (auto x : depth)
+				MockCore::Arg(args, "depth", x);
+			MockCore::Arg(args, "chroma", chroma);
+		};
+		auto as_source = [&](auto& frame) {
+			return mock.Source(format, width, height, 1, [&](auto x) { *x = *frame; });
+		};
+		// frames of any mask storage are compared as the floats the filters read back from them.
+		auto reference = select_kernels(ISA::None, 1ll, false);
+		auto compare = [&](auto check, auto bound, auto& expected, auto& actual) {
+			for (auto plane : Range{ expected->format->numPlanes }) {
+				auto scratch = std::array{ std::vector<float>(expected->width[plane]), std::vector<float>(expected->width[plane]) };
+				auto row = [&](auto& frame, auto& buffer) {
+					return [&, plane](auto y) {
+						auto samples = format_samples(frame->format);
+						return samples.Widen(reference, frame->planes[plane].get() + y * frame->stride[plane], frame->width[plane], buffer.data());
+					};
+				};
+				checker.Compare(check, bound, expected->width[plane], expected->height[plane], row(expected, scratch[0]), row(actual, scratch[1]));
+			}
+		};
+		using Configure = std::function<void(VSMap&)>;
+		auto filters = std::vector<std::tuple<std::string, Configure, Configure, double>>{
+			{ "ASobel", sobel_args, sobel_args, std::ldexp(1., -19) },
+			{ collapse ? "ABlur collapse" : "ABlur", blur_args(clip, collapse), blur_args(clip, std::int64_t{ 0 }), collapse ? std::ldexp(1., -22) : blur_level * std::ldexp(1., -22) },
+			{ "AWarp" + factor_name, warp_args(upsampled, mask), warp_args(upsampled, mask), std::ldexp(1., -22) },
+			{ "ASobel integer", integer_sobel_args, integer_sobel_args, std::ldexp(1., -19) },
+			{ "AWarp integer" + factor_name, warp_args(integer_upsampled, mask), warp_args(integer_upsampled, mask), 0. }
+		};
+		for (auto& [check, configure, reference, bound] : filters) {
+			auto name = check.substr(0, check.find(' '));
+			auto expected = render(name, reference, 1ll, 1ll, 1ll, 0);
+			for (auto opt : options) {
+				auto actual = render(name, configure, opt, 0ll, 1ll, 0);
+				auto banded = render(name, configure, opt, 0ll, 0ll, padding);
+				compare("getframe " + check + " opt " + std::to_string(opt), bound, expected, actual);
+				compare("getframe " + check + " threads/stride", 0., actual, banded);
+			}
+		}
+		// a mask 2 or 4 times smaller than the output, with gradients upsampled on the fly, which precision=1 does in
+		// single precision as well.
+		auto upsample = std::int64_t{ 1 } << uniform(1, 2);
+		auto reduced_mask = random_source(format, width / upsample, height / upsample);
+		auto reduced_format = uniform(0, 1) == 0 ? format : integer_format;
+		auto reduced_source = random_source(reduced_format, width / upsample * upsample * factor, height / upsample * upsample * factor);
+		auto reduced_args = [&](auto& args) {
+			warp_args(reduced_source, reduced_mask)(args);
+			MockCore::Arg(args, "upsample", upsample);
+		};
+		auto reduced_name = "getframe AWarp upsample " + std::to_string(upsample) + factor_name + (reduced_format == format ? "" : " integer");
+		auto reduced_expected = render("AWarp", reduced_args, 1ll, 1ll, 1ll, 0);
+		for (auto opt : options) {
+			auto actual = render("AWarp", reduced_args, opt, 0ll, 1ll, 0);
+			auto banded = render("AWarp", reduced_args, opt, 0ll, 0ll, padding);
+			compare(reduced_name + " opt " + std::to_string(opt), reduced_format == format ? std::ldexp(1., -22) : 0., reduced_expected, actual);
+			compare(reduced_name + " threads/stride", 0., actual, banded);
+		}
+		// an array of clips comes out of AWarp as one output per clip, each the same as warping that clip on its own, in
+		// whichever order the outputs are asked for, and every output after the first comes off the shelf without
+		// requesting the mask again.
+		auto clips = std::vector{ upsampled };
+		for (auto _ [[maybe_unused]] : Range{ uniform(1, 2) })
+			clips.push_back(random_source(format, width * factor, height * factor));
+		auto clips_opt = options[uniform(0, static_cast<int>(options.size()) - 1)];
+		auto clips_args = VSMap{};
+		for (auto& x : clips)
+			MockCore::Arg(clips_args, "clip", x);
+		MockCore::Arg(clips_args, "mask", mask);
+		for (auto x : depth)
+			MockCore::Arg(clips_args, "depth", x);
+		MockCore::Arg(clips_args, "chroma", chroma);
+		MockCore::Arg(clips_args, "opt", std::int64_t{ clips_opt });
+		MockCore::Arg(clips_args, "threads", 0ll);
+		auto clips_out = mock.Invoke("AWarp", clips_args);
+		checker.Record("getframe AWarp clips outputs", 0., clips_out.error.empty() && MockCore::Count(clips_out, "clip") == static_cast<int>(clips.size()));
+		auto order = std::vector<int>(clips.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), rng);
+		for (auto index : order) {
+			auto expected = render("AWarp", warp_args(clips[index], mask), clips_opt, 0ll, 1ll, 0);
+			auto requests = mask->node->requests;
+			auto actual = mock.GetFrame(MockCore::Clip(clips_out, index), 0);
+			compare("getframe AWarp clips" + factor_name, 0., expected, actual);
+			checker.Record("getframe AWarp clips shelved", 0., index == order[0] || mask->node->requests == requests);
+		}
+		// the core entry points chained by hand on buffers of their own, with strides the mock never uses and the edges
+		// standing in for the planes with no blur passes, give the frames of ASobel, ABlur and AWarp chained in the plugin.
+		auto core_opt = static_cast<long long>(uniform(1, static_cast<int>(SupportedISA()) + 1));
+		auto core_isa = static_cast<ISA>(core_opt - 1);
+		auto core_arena = ScratchArena{};
+		auto core_options = CoreOptions{ Tuning{ core_isa, core_isa, core_isa, L2CacheBytes() }, static_cast<long long>(uniform(1, 4)), true, uniform(0, 1) == 0 ? &core_arena : nullptr };
+		auto core_levels = std::array<long long, 3>{ blur_level, (blur_level + 1) / 2, (blur_level + 1) / 2 };
+		auto core_storage = std::vector<std::vector<std::uint8_t>>{};
+		auto caller_frame = [&](auto use) {
+			auto span = TargetFrame{};
+			span.samples = format_samples(format);
+			for (auto plane : Range{ format->numPlanes }) {
+				auto stride = width * 4 + 4 * uniform(0, 15);
+				auto& buffer = core_storage.emplace_back(static_cast<std::size_t>(stride) * height);
+				span.planes[plane] = { use[plane] ? buffer.data() : nullptr, stride, width, height };
+			}
+			return span;
+		};
+		auto as_read = [&](auto& frame) {
+			auto span = SourceFrame{};
+			span.samples = frame.samples;
+			for (auto plane : Range{ 3 })
+				span.planes[plane] = { frame[plane].data, frame[plane].stride, frame[plane].width, frame[plane].height };
+			return span;
+		};
+		auto clip_frame = mock.GetFrame(clip, 0);
+		auto clip_span = SourceFrame{};
+		clip_span.samples = format_samples(format);
+		for (auto plane : Range{ format->numPlanes })
+			clip_span.planes[plane] = { clip_frame->planes[plane].get(), clip_frame->stride[plane], clip_frame->width[plane], clip_frame->height[plane] };
+		auto all = std::array{ true, true, true };
+		auto core_edges = caller_frame(all);
+		auto core_mask = caller_frame(std::array{ core_levels[0] > 0, core_levels[1] > 0, core_levels[2] > 0 });
+		auto core_sources = std::vector{ clip_span };
+		auto core_targets = std::vector{ caller_frame(all) };
+		sobel_frame(core_options, clip_span, core_edges, all, thresh / 256.);
+		blur_frame(core_options, as_read(core_edges), core_mask, blur_type, core_levels, nullptr);
+		for (auto plane : Range{ 3 })
+			if (core_mask[plane].data == nullptr)
+				core_mask.planes[plane] = core_edges[plane];
+		warp_frames(core_options, core_sources, core_targets, as_read(core_mask), depth, chroma == 0, false, 0, 0);
+		auto chained = [&](auto name, auto configure) {
+			auto args = VSMap{};
+			configure(args);
+			MockCore::Arg(args, "opt", std::int64_t{ core_opt });
+			return MockCore::Clip(mock.Invoke(name, args));
+		};
+		auto plugin_edges = chained("ASobel", sobel_args);
+		auto plugin_mask = chained("ABlur", blur_args(plugin_edges, std::int64_t{ 0 }));
+		auto plugin_frames = std::array{ mock.GetFrame(plugin_edges, 0), mock.GetFrame(plugin_mask, 0), mock.GetFrame(chained("AWarp", warp_args(clip, plugin_mask)), 0) };
+		auto core_frames = std::array{ &core_edges, &core_mask, &core_targets[0] };
+		for (auto stage : Range{ 3 })
+			for (auto plane : Range{ format->numPlanes })
+				checker.Compare("core entry points", 0., width, height,
+					[&](auto y) { return reinterpret_cast<const float*>(plugin_frames[stage]->planes[plane].get() + y * plugin_frames[stage]->stride[plane]); },
+					[&](auto y) { return reinterpret_cast<const float*>((*core_frames[stage])[plane].Row(y)); });
+		// ABlur hands the planes it leaves alone over from its source without a copy and blurs the rest as usual.
+		auto blur_plane = static_cast<std::int64_t>(uniform(0, format->numPlanes - 1));
+		auto source_frame = mock.GetFrame(clip, 0);
+		for (auto opt : options) {
+			auto full = render("ABlur", blur_args(clip, std::int64_t{ 0 }), opt, 0ll, 1ll, 0);
+			auto partial = render("ABlur", [&](auto& args) {
+				blur_args(clip, std::int64_t{ 0 })(args);
+				MockCore::Arg(args, "planes", blur_plane);
+			}, opt, 0ll, 0ll, padding);
+			for (auto plane : Range{ format->numPlanes }) {
+				auto& expected = plane == blur_plane && blur_level > 0 ? full : source_frame;
+				auto shared = partial->planes[plane] == source_frame->planes[plane];
+				checker.Compare("getframe ABlur planes", 0., partial->width[plane], partial->height[plane],
+					[&](auto y) { return reinterpret_cast<const float*>(expected->planes[plane].get() + y * expected->stride[plane]); },
+					[&](auto y) { return reinterpret_cast<const float*>(partial->planes[plane].get() + y * partial->stride[plane]); }, shared == (plane != blur_plane || blur_level == 0));
+			}
+		}
+		// planes with depth=0 come out of AWarp and AWarpSharp as the planes of clip above the last row, which the
+		// vertical clamp blends with the row above like any other.
+		for (auto opt : options)
+			for (auto name : { "AWarp", "AWarpSharp" }) {
+				auto warped = render(name, name == "AWarp"s ? Configure{ warp_args(clip, mask) } : Configure{ sharp_args }, opt, 0ll, 0ll, padding);
+				for (auto plane : Range{ format->numPlanes })
+					if (depth[plane] == 0)
+						checker.Compare("getframe depth 0 copy", 0., warped->width[plane], warped->height[plane] - 1,
+							[&](auto y) { return reinterpret_cast<const float*>(source_frame->planes[plane].get() + y * source_frame->stride[plane]); },
+							[&](auto y) { return reinterpret_cast<const float*>(warped->planes[plane].get() + y * warped->stride[plane]); });
+			}
+		// with depth=0 on every plane AWarp never requests its mask, and any other mask gives the same frame.
+		auto still_args = [&](auto edges) {
+			return [&, edges](auto& args) {
+				MockCore::Arg(args, "clip", clip);
+				MockCore::Arg(args, "mask", edges);
+				for (auto _ [[maybe_unused]] : Range{ 3 })
+					MockCore::Arg(args, "depth", 0ll);
+				MockCore::Arg(args, "chroma", chroma);
+			};
+		};
+		for (auto opt : options) {
+			auto requests = mask->node->requests;
+			auto still = render("AWarp", still_args(mask), opt, 0ll, 0ll, padding);
+			checker.Record("getframe depth 0 mask unused", 0., mask->node->requests == requests);
+			auto other = render("AWarp", still_args(clip), opt, 0ll, 1ll, 0);
+			compare("getframe depth 0 mask", 0., other, still);
+		}
+		for (auto opt : options)
+			for (auto precision : { 0ll, 1ll }) {
+				auto fused = render("AWarpSharp", sharp_args, opt, precision, 0ll, padding);
+				auto sobel = render("ASobel", sobel_args, opt, precision, 1ll, 0);
+				auto blurred = render("ABlur", blur_args(as_source(sobel), std::int64_t{ 0 }), opt, precision, 1ll, 0);
+				auto warped = render("AWarp", warp_args(clip, as_source(blurred)), opt, precision, 1ll, 0);
+				compare("getframe AWarpSharp fused", 0., warped, fused);
+			}
+		auto storage = static_cast<std::int64_t>(uniform(1, 3));
+		auto storage_format = std::array{ format, mock.Format(format->colorFamily, stFloat, 16), mock.Format(format->colorFamily, stInteger, 8), mock.Format(format->colorFamily, stInteger, 16) }[storage];
+		auto quantization = [](auto mask_format) {
+			return mask_format->sampleType == stFloat ? std::ldexp(1., -12) : .5 / format_samples(mask_format).peak + 1e-7;
+		};
+		auto storage_name = " storage " + std::to_string(storage);
+		auto stored_sobel = [&](auto& args) {
+			sobel_args(args);
+			MockCore::Arg(args, "storage", storage);
+		};
+		auto expected_sobel = render("ASobel", sobel_args, 1ll, 1ll, 1ll, 0);
+		for (auto opt : options) {
+			auto actual = render("ASobel", stored_sobel, opt, 0ll, 1ll, 0);
+			auto banded = render("ASobel", stored_sobel, opt, 0ll, 0ll, padding);
+			compare("getframe ASobel" + storage_name + " opt " + std::to_string(opt), std::ldexp(1., -19) + quantization(storage_format), expected_sobel, actual);
+			compare("getframe ASobel" + storage_name + " threads/stride", 0., actual, banded);
+		}
+		// a random mask in the compact storage (including 10 bits in 16-bit words), and the floats it stands for.
+		auto mask_format = storage == 3 && uniform(0, 1) == 1 ? mock.Format(format->colorFamily, stInteger, 10) : storage_format;
+		auto stored_mask = mock.Source(mask_format, width, height, 1, [&](auto frame) {
+			auto samples = format_samples(mask_format);
+			auto values = Plane{ width, 1, width };
+			for (auto plane : Range{ mask_format->numPlanes })
+				for (auto y : Range{ frame->height[plane] }) {
+					values.Fill(rng);
+					samples.Narrow(reference, values.row(0), frame->width[plane], frame->planes[plane].get() + y * frame->stride[plane]);
+				}
+		});
+		auto stored_frame = mock.GetFrame(stored_mask, 0);
+		auto widened_mask = mock.Source(format, width, height, 1, [&](auto frame) {
+			auto samples = format_samples(mask_format);
+			for (auto plane : Range{ format->numPlanes })
+				for (auto y : Range{ frame->height[plane] }) {
+					auto dstp = reinterpret_cast<float*>(frame->planes[plane].get() + y * frame->stride[plane]);
+					auto row = samples.Widen(reference, stored_frame->planes[plane].get() + y * stored_frame->stride[plane], frame->width[plane], dstp);
+					std::memmove(dstp, row, frame->width[plane] * sizeof(float));
+				}
+		});
+		auto mask_name = " mask " + std::to_string(mask_format->bitsPerSample) + (mask_format->sampleType == stFloat ? "f" : "");
+		auto expected_blur = render("ABlur", blur_args(widened_mask, std::int64_t{ 0 }), 1ll, 1ll, 1ll, 0);
+		for (auto opt : options) {
+			auto actual = render("ABlur", blur_args(stored_mask, std::int64_t{ 0 }), opt, 0ll, 1ll, 0);
+			auto banded = render("ABlur", blur_args(stored_mask, std::int64_t{ 0 }), opt, 0ll, 0ll, padding);
+			compare("getframe ABlur" + mask_name + " opt " + std::to_string(opt), blur_level * std::ldexp(1., -22) + quantization(mask_format), expected_blur, actual);
+			compare("getframe ABlur" + mask_name + " threads/stride", 0., actual, banded);
+			auto expected = render("AWarp", warp_args(upsampled, widened_mask), opt, 0ll, 1ll, 0);
+			auto warped = render("AWarp", warp_args(upsampled, stored_mask), opt, 0ll, 0ll, padding);
+			compare("getframe AWarp" + mask_name, 0., expected, warped);
+		}
+		// subsampled chroma, warped along the luma mask or by its own mask, from same size and supersampled sources.
+		auto ssw = uniform(0, 1);
+		auto ssh = uniform(ssw == 0 ? 1 : 0, 1);
+		auto even_width = width >> ssw << ssw;
+		auto even_height = height >> ssh << ssh;
+		auto subsampled_format = uniform(0, 1) == 0 ? mock.Format(cmYUV, stFloat, 32, ssw, ssh) : mock.Format(cmYUV, stInteger, integer_format->bitsPerSample, ssw, ssh);
+		auto subsampled_mask = random_source(mock.Format(cmYUV, stFloat, 32, ssw, ssh), even_width, even_height);
+		auto subsampled_source = random_source(subsampled_format, even_width * factor, even_height * factor);
+		auto subsampled_name = "getframe AWarp "s + (ssw ? ssh ? "420" : "422" : "440") + (subsampled_format->sampleType == stFloat ? "" : " integer");
+		for (auto chroma_mode : { 0ll, 1ll }) {
+			auto subsampled_args = [&](auto& args) {
+				warp_args(subsampled_source, subsampled_mask)(args);
+				args.props.erase("chroma");
+				MockCore::Arg(args, "chroma", std::int64_t{ chroma_mode });
+			};
+			auto name = subsampled_name + factor_name + " chroma " + std::to_string(chroma_mode);
+			auto expected = render("AWarp", subsampled_args, 1ll, 1ll, 1ll, 0);
+			for (auto opt : options) {
+				auto actual = render("AWarp", subsampled_args, opt, 0ll, 1ll, 0);
+				auto banded = render("AWarp", subsampled_args, opt, 0ll, 0ll, padding);
+				compare(name + " opt " + std::to_string(opt), subsampled_format->sampleType == stFloat ? std::ldexp(1., -22) : 0., expected, actual);
+				compare(name + " threads/stride", 0., actual, banded);
+				// the displacement clip of the same mask has to reproduce AWarp exactly.
+				auto field_args = VSMap{};
+				subsampled_args(field_args);
+				field_args.props.erase("clip");
+				MockCore::Arg(field_args, "opt", std::int64_t{ opt });
+				MockCore::Arg(field_args, "threads", 0ll);
+				auto field = mock.Invoke("ADisplacement", field_args);
+				if (field.error.empty() == false) {
+					std::cerr << field.error << std::endl;
+					std::exit(1);
+				}
+				auto displaced = render("AWarp", [&](auto& args) {
+					MockCore::Arg(args, "clip", subsampled_source);
+					MockCore::Arg(args, "displacement", MockCore::Clip(field));
+				}, opt, 0ll, 0ll, padding);
+				compare(subsampled_name + factor_name + " displacement chroma " + std::to_string(chroma_mode), 0., actual, displaced);
+			}
+		}
+		// subpixel sampling of a same size source against the reference upscale, by the mask and by its displacement clip.
+		auto resampled_source = random_source(subsampled_format, even_width, even_height);
+		auto resampled_bound = subsampled_format->sampleType == stFloat ? std::ldexp(1., -19) : 1. / format_samples(subsampled_format).peak + 1e-7;
+		for (auto subpixel : { 1ll, 2ll }) {
+			auto resampled_args = [&](auto& args) {
+				warp_args(resampled_source, subsampled_mask)(args);
+				MockCore::Arg(args, "subpixel", std::int64_t{ subpixel });
+			};
+			auto name = subsampled_name + " subpixel " + std::to_string(subpixel);
+			auto expected = render("AWarp", resampled_args, 1ll, 1ll, 1ll, 0);
+			for (auto opt : options) {
+				auto actual = render("AWarp", resampled_args, opt, 0ll, 1ll, 0);
+				auto banded = render("AWarp", resampled_args, opt, 0ll, 0ll, padding);
+				compare(name + " opt " + std::to_string(opt), resampled_bound, expected, actual);
+				compare(name + " threads/stride", 0., actual, banded);
+				auto field_args = VSMap{};
+				warp_args(resampled_source, subsampled_mask)(field_args);
+				field_args.props.erase("clip");
+				MockCore::Arg(field_args, "opt", std::int64_t{ opt });
+				auto field = mock.Invoke("ADisplacement", field_args);
+				if (field.error.empty() == false) {
+					std::cerr << field.error << std::endl;
+					std::exit(1);
+				}
+				auto displaced = render("AWarp", [&](auto& args) {
+					MockCore::Arg(args, "clip", resampled_source);
+					MockCore::Arg(args, "displacement", MockCore::Clip(field));
+					MockCore::Arg(args, "subpixel", std::int64_t{ subpixel });
+				}, opt, 0ll, 1ll, 0);
+				compare(name + " displacement", 0., actual, displaced);
+			}
+		}
+	}
+	return checker.Report() ? 1 : 0;
+}
\ No newline at end of file
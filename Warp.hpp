@@ -0,0 +1,289 @@
+// included by Core.hpp once per instruction set with gathers and once for the portable fallback, inside the matching
+// namespace and target region.
+// the displacement is computed as (round(gradient * 256) * depth) >> 1, which is the same integer as the reference
+// ((round(gradient * 256) << 7) * (depth << 8)) >> 16 but fits in 32 bits once the rounded gradient is clamped to
+// +-2^23, a bound that no plane up to 32768 pixels in either dimension can tell apart from the unclamped value.
+// integer sources are interpolated in 32-bit integers with the same 7-bit weights and rounded once at the end, which
+// is exactly the rounded reference. each gather fetches the 32 bits starting at the left sample, so both horizontal
+// neighbours come from one load that never reaches past the last sample of the row.
+// a subsampled plane warped along luma takes the luma displacement at its co-sited luma sample, shifted right by the
+// subsampling so it is measured in samples of the plane; the luma mask rows are then gathered at every 2nd sample.
+
+// round(gradient * 256) clamped to +-2^23, the only part of the displacement that does not depend on depth.
+inline auto scaled_gradient = [](auto gradient) {
+	auto gradient_limit = 8388608.f;
+	if constexpr (std::is_floating_point_v<decltype(gradient)>)
+		return static_cast<int>(std::nearbyint(std::min(std::max(gradient * 256.f, -gradient_limit), gradient_limit)));
+	else
+		return to_integer(min(max(gradient * broadcast(256.f), broadcast(-gradient_limit)), broadcast(gradient_limit)));
+};
+
+// calls body with SMAGL as a compile time constant, so every supersampling factor from 1 to 8 gets its own loop
+// with constant shifts.
+inline auto specialize_factor = [](auto SMAGL, auto body) {
+	if (SMAGL == 0)
+		body(std::integral_constant<int, 0>{});
+	else if (SMAGL == 1)
+		body(std::integral_constant<int, 1>{});
+	else if (SMAGL == 2)
+		body(std::integral_constant<int, 2>{});
+	else
+		body(std::integral_constant<int, 3>{});
+};
+
+// displaces and interpolates samples [first_x, last_x) of one row. scalar_gradients(x) and vector_gradients(x, tail...)
+// give the scaled horizontal and vertical gradients at sample x of the row, either from the mask or precomputed.
+inline auto warp_samples = [](auto scalar_gradients, auto vector_gradients, auto srcp, auto dstp, auto src_stride, auto width, auto first_x, auto last_x, auto y, auto height, auto depth, auto SMAGL, auto ssw, auto ssh) {
+	using Sample = std::decay_t<decltype(*srcp)>;
+	auto x_limit_max = static_cast<int>((width - 1) << SMAGL);
+	auto window = x_limit_max + 1 - static_cast<int>(sizeof(int) / sizeof(Sample));
+	auto pixel = [&](auto x) {
+		auto [scaled_h, scaled_v] = scalar_gradients(x);
+		auto h = (scaled_h * static_cast<int>(depth) >> 1) >> ssw, v = (scaled_v * static_cast<int>(depth) >> 1) >> ssh;
+		v = std::min(std::max(v, static_cast<int>(-y * 128)), static_cast<int>((height - y) * 128 - 129));
+		auto remainder_h = (h << SMAGL) & 127, remainder_v = (v << SMAGL) & 127;
+		h >>= 7 - SMAGL;
+		v >>= 7 - SMAGL;
+		h += static_cast<int>(x << SMAGL);
+		if (auto remainder_needed = (x_limit_max > h) && !(h < 0); remainder_needed == false)
+			remainder_h = 0;
+		h = std::max(std::min(h, x_limit_max), 0);
+		auto h_right = std::min(h + 1, x_limit_max);
+		auto upper = srcp + v * src_stride;
+		auto lower = upper + src_stride;
+		if constexpr (std::is_integral_v<Sample>) {
+			auto s0 = (upper[h] << 7) + (upper[h_right] - upper[h]) * remainder_h;
+			auto s1 = (lower[h] << 7) + (lower[h_right] - lower[h]) * remainder_h;
+			return static_cast<Sample>(((s0 << 7) + (s1 - s0) * remainder_v + 8192) >> 14);
+		}
+		else {
+			auto [weight_h, weight_v] = std::array{ remainder_h / 128.f, remainder_v / 128.f };
+			auto s0 = upper[h] + (upper[h_right] - upper[h]) * weight_h;
+			auto s1 = lower[h] + (lower[h_right] - lower[h]) * weight_h;
+			return s0 + (s1 - s0) * weight_v;
+		}
+	};
+	auto fraction = broadcast(1.f / 128.f);
+	auto vector_depth = broadcast(static_cast<int>(depth));
+	auto mask127 = broadcast(127);
+	auto zero = broadcast(0);
+	auto minus_one = broadcast(-1);
+	auto one = broadcast(1);
+	auto x_limit = broadcast(x_limit_max);
+	auto stride = broadcast(static_cast<int>(src_stride));
+	auto v_min = broadcast(static_cast<int>(-y * 128));
+	auto v_max = broadcast(static_cast<int>((height - y) * 128 - 129));
+	auto last_window = broadcast(window);
+	auto sample_mask = broadcast(static_cast<int>((1ll << 8 * sizeof(Sample)) - 1));
+	auto rounding = broadcast(8192);
+	auto sample_shift = sizeof(Sample) == 1 ? 3 : 4;
+	auto [vector_first, vector_last] = std::array{ std::max(static_cast<int>(first_x), 1), std::min(static_cast<int>(last_x), static_cast<int>(width - 1)) };
+	if (first_x == 0)
+		dstp[0] = pixel(0);
+	if (window < 0)
+		for (auto x : Range{ vector_first, vector_last, 1 })
+			dstp[x] = pixel(x);
+	else for_each_group(vector_first, vector_last, [&](auto x, auto...tail) {
+		auto [scaled_h, scaled_v] = vector_gradients(x, tail...);
+		auto h = (scaled_h * vector_depth >> 1) >> ssw;
+		auto v = (scaled_v * vector_depth >> 1) >> ssh;
+		v = min(max(v, v_min), v_max);
+		auto remainder_h = (h << SMAGL) & mask127, remainder_v = (v << SMAGL) & mask127;
+		h = (h >> (7 - SMAGL)) + ((iota() + broadcast(static_cast<int>(x))) << SMAGL);
+		v = v >> (7 - SMAGL);
+		remainder_h = select((x_limit > h) & (h > minus_one), remainder_h, zero);
+		h = max(min(h, x_limit), zero);
+		auto h_right = min(h + one, x_limit);
+		auto offset = v * stride;
+		if constexpr (std::is_integral_v<Sample>) {
+			auto start = min(h, last_window);
+			auto [shift_left, shift_right] = std::array{ (h - start) << sample_shift, (h_right - start) << sample_shift };
+			auto upper = gather(srcp, offset + start), lower = gather(srcp + src_stride, offset + start);
+			auto [upper_left, upper_right] = std::array{ (upper >> shift_left) & sample_mask, (upper >> shift_right) & sample_mask };
+			auto [lower_left, lower_right] = std::array{ (lower >> shift_left) & sample_mask, (lower >> shift_right) & sample_mask };
+			auto s0 = (upper_left << 7) + (upper_right - upper_left) * remainder_h;
+			auto s1 = (lower_left << 7) + (lower_right - lower_left) * remainder_h;
+			store(dstp + x, to_float(((s0 << 7) + (s1 - s0) * remainder_v + rounding) >> 14), tail...);
+		}
+		else {
+			auto [weight_h, weight_v] = std::array{ to_float(remainder_h) * fraction, to_float(remainder_v) * fraction };
+			auto upper_left = gather(srcp, offset + h), upper_right = gather(srcp, offset + h_right);
+			auto lower_left = gather(srcp + src_stride, offset + h), lower_right = gather(srcp + src_stride, offset + h_right);
+			auto s0 = fmadd(upper_right - upper_left, weight_h, upper_left);
+			auto s1 = fmadd(lower_right - lower_left, weight_h, lower_left);
+			store(dstp + x, fmadd(s1 - s0, weight_v, s0), tail...);
+		}
+	});
+	if (width > 1 && last_x == width)
+		dstp[width - 1] = pixel(width - 1);
+};
+
+// samples of a mask or gradient row at the co-sited positions of a plane subsampled by ssw against it.
+inline auto cosited = [](auto row, auto x, auto offset, auto last, auto ssw, auto...tail) {
+	if (ssw == 0)
+		return load(row + x + offset, tail...);
+	return gather(row, min(((iota() + broadcast(static_cast<int>(x))) << ssw) + broadcast(offset), broadcast(last)));
+};
+
+inline auto warp_row = [](auto srcp, auto above, auto edgep, auto below, auto dstp, auto src_stride, auto width, auto y, auto height, auto depth, auto SMAGL, auto ssw, auto ssh) {
+	auto mask_last = static_cast<int>((width << ssw) - 1);
+	specialize_factor(SMAGL, [&](auto SMAGL) {
+		warp_samples(
+			[&](auto x) {
+				auto center = static_cast<int>(x << ssw);
+				auto [left, right] = std::array{ edgep[std::max(center - 1, 0)], edgep[std::min(center + 1, mask_last)] };
+				return std::array{ scaled_gradient(left - right), scaled_gradient(above[center] - below[center]) };
+			},
+			[&](auto x, auto...tail) {
+				auto [left, right] = std::array{ cosited(edgep, x, -1, mask_last, ssw, tail...), cosited(edgep, x, 1, mask_last, ssw, tail...) };
+				return std::array{ scaled_gradient(left - right), scaled_gradient(cosited(above, x, 0, mask_last, ssw, tail...) - cosited(below, x, 0, mask_last, ssw, tail...)) };
+			},
+			srcp, dstp, src_stride, width, 0, width, y, height, depth, SMAGL, ssw, ssh);
+	});
+};
+
+// the scaled gradients of one mask row, computed once and shared by every plane warped along it.
+inline auto gradient_row = [](auto above, auto edgep, auto below, auto gradient_h, auto gradient_v, auto width) {
+	auto border = [&](auto x) {
+		gradient_h[x] = scaled_gradient(edgep[std::max(x - 1, 0)] - edgep[std::min(x + 1, width - 1)]);
+		gradient_v[x] = scaled_gradient(above[x] - below[x]);
+	};
+	border(0);
+	for_each_group(1, width - 1, [&](auto x, auto...tail) {
+		store(gradient_h + x, scaled_gradient(load(edgep + x - 1, tail...) - load(edgep + x + 1, tail...)), tail...);
+		store(gradient_v + x, scaled_gradient(load(above + x, tail...) - load(below + x, tail...)), tail...);
+	});
+	if (width > 1)
+		border(width - 1);
+};
+
+inline auto warp_gradient_row = [](auto srcp, auto gradient_h, auto gradient_v, auto dstp, auto src_stride, auto width, auto first_x, auto last_x, auto y, auto height, auto depth, auto SMAGL, auto ssw, auto ssh) {
+	auto gradient_last = static_cast<int>((width << ssw) - 1);
+	specialize_factor(SMAGL, [&](auto SMAGL) {
+		warp_samples(
+			[&](auto x) { return std::array{ gradient_h[x << ssw], gradient_v[x << ssw] }; },
+			[&](auto x, auto...tail) { return std::array{ cosited(gradient_h, x, 0, gradient_last, ssw, tail...), cosited(gradient_v, x, 0, gradient_last, ssw, tail...) }; },
+			srcp, dstp, src_stride, width, first_x, last_x, y, height, depth, SMAGL, ssw, ssh);
+	});
+};
+
+// the scaled gradients at the samples of a plane 1 << shift times the size of its mask in each dimension. the gradient
+// rows of the mask rows above and below the plane row are blended by weight out of 2 << shift into blended_h and
+// blended_v, then every plane sample blends the two mask samples around its centred position the same way, and the sum
+// is divided by 1 << shift once more so it stays a gradient per sample of the plane, rounded half up. it is all integer
+// arithmetic, so every instruction set gives the same rows.
+inline auto upsample_gradient_row = [](auto above_h, auto above_v, auto below_h, auto below_v, auto weight, auto blended_h, auto blended_v, auto gradient_h, auto gradient_v, auto mask_width, auto width, auto shift) {
+	auto [keep, take] = std::array{ broadcast((2 << shift) - weight), broadcast(weight) };
+	for_each_group(0, mask_width, [&](auto x, auto...tail) {
+		store(blended_h + x, load(above_h + x, tail...) * keep + load(below_h + x, tail...) * take, tail...);
+		store(blended_v + x, load(above_v + x, tail...) * keep + load(below_v + x, tail...) * take, tail...);
+	});
+	auto [phases, offset, one, last] = std::array{ broadcast((2 << shift) - 1), broadcast(1 - (1 << shift)), broadcast(1), broadcast(mask_width - 1) };
+	auto [zero, total, rounding] = std::array{ broadcast(0), broadcast(2 << shift), broadcast(1 << (3 * shift + 1)) };
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		auto position = ((iota() + broadcast(static_cast<int>(x))) << 1) + offset;
+		auto [fraction, left] = std::array{ position & phases, position >> (shift + 1) };
+		auto right = min(left + one, last);
+		left = max(left, zero);
+		auto blend = [&](auto row) { return (gather(row, left) * (total - fraction) + gather(row, right) * fraction + rounding) >> (3 * shift + 2); };
+		store(gradient_h + x, blend(blended_h), tail...);
+		store(gradient_v + x, blend(blended_v), tail...);
+	});
+};
+
+// the displacement in 1/128 samples that warp_samples derives from the scaled gradients, for a plane subsampled by ssw
+// and ssh against them. warping by it as gradients with depth 2 and no subsampling gives the same samples again.
+inline auto displacement_row = [](auto gradient_h, auto gradient_v, auto displacement_h, auto displacement_v, auto width, auto depth, auto ssw, auto ssh) {
+	auto gradient_last = static_cast<int>((width << ssw) - 1);
+	auto vector_depth = broadcast(static_cast<int>(depth));
+	for_each_group(0, width, [&](auto x, auto...tail) {
+		store(displacement_h + x, (cosited(gradient_h, x, 0, gradient_last, ssw, tail...) * vector_depth >> 1) >> ssw, tail...);
+		store(displacement_v + x, (cosited(gradient_v, x, 0, gradient_last, ssw, tail...) * vector_depth >> 1) >> ssh, tail...);
+	});
+};
+
+// weights of the taps source samples around a position t past the first sample at or before it, t in [0, 1):
+// bilinear for 2 taps, bicubic with b = c = 1/3 (the resize.Bicubic default) for 4, starting 1 sample before.
+inline auto resample_weights = [](auto t, auto taps) {
+	auto one = broadcast(1.f);
+	if (taps == 2)
+		return std::array{ one - t, t, broadcast(0.f), broadcast(0.f) };
+	auto inner = [](auto d) { return fmadd(fmadd(broadcast(7.f / 6.f), d, broadcast(-2.f)), d * d, broadcast(8.f / 9.f)); };
+	auto outer = [](auto d) { return fmadd(fmadd(fmadd(broadcast(-7.f / 18.f), d, broadcast(2.f)), d, broadcast(-10.f / 3.f)), d, broadcast(16.f / 9.f)); };
+	return std::array{ outer(one + t), inner(t), inner(one - t), outer(broadcast(2.f) - t) };
+};
+
+// sample i of the implicit 4x upscale sits at (i + 1/2) / 4 - 1/2 source samples, (i - 2) / 4 + 1/8, so its taps start
+// at ((i - 2) >> 2) - taps / 2 + 1 with one of 4 phases. the warp blends upscaled samples position and next by fraction,
+// and their taps start 0 or 1 sample apart, so the blend is one filter of taps + 1 weights over source samples.
+inline auto fold_axis = [](auto position, auto next, auto fraction, auto taps) {
+	auto [two, three] = std::array{ broadcast(2), broadcast(3) };
+	auto phase = [&](auto i) { return fmadd(to_float((i - two) & three), broadcast(.25f), broadcast(.125f)); };
+	auto [first, second] = std::array{ resample_weights(phase(position), taps), resample_weights(phase(next), taps) };
+	auto start = (position - two) >> 2;
+	auto shift = to_float(((next - two) >> 2) - start);
+	auto keep = broadcast(1.f) - fraction;
+	auto zero = broadcast(0.f);
+	auto weights = std::array{ zero, zero, zero, zero, zero };
+	for (auto k : Range{ taps + 1 }) {
+		auto [unshifted, shifted] = std::array{ k < taps ? second[k] : zero, k > 0 ? second[k - 1] : zero };
+		weights[k] = fmadd(keep, k < taps ? first[k] : zero, fraction * fmadd(shift, shifted - unshifted, unshifted));
+	}
+	return std::pair{ start - broadcast(taps / 2 - 1), weights };
+};
+
+// subpixel sampling: the source is the plane itself, read as its 4x upscale by resample_weights with centred samples
+// and repeated edges, and displaced like a 4x clip with SMAGL 2. srcp points at the first row, and peak clamps the
+// overshoot of bicubic taps for integer samples.
+inline auto warp_resampled_row = [](auto srcp, auto gradient_h, auto gradient_v, auto dstp, auto src_stride, auto width, auto first_x, auto last_x, auto y, auto height, auto depth, auto ssw, auto ssh, auto taps, auto peak) {
+	using Sample = std::decay_t<decltype(*srcp)>;
+	auto gradient_last = static_cast<int>((width << ssw) - 1);
+	auto fraction = broadcast(1.f / 128.f);
+	auto vector_depth = broadcast(static_cast<int>(depth));
+	auto mask127 = broadcast(127);
+	auto zero = broadcast(0);
+	auto minus_one = broadcast(-1);
+	auto one = broadcast(1);
+	auto x_limit = broadcast(static_cast<int>((width - 1) << 2));
+	auto v_min = broadcast(static_cast<int>(-y * 128));
+	auto v_max = broadcast(static_cast<int>((height - y) * 128 - 129));
+	auto upscaled_row = broadcast(static_cast<int>(y << 2));
+	auto [last_column, last_row] = std::array{ broadcast(static_cast<int>(width - 1)), broadcast(static_cast<int>(height - 1)) };
+	auto stride = broadcast(static_cast<int>(src_stride));
+	// integer samples come from 32-bit gathers, moved back where needed so the last one ends at the last sample.
+	auto last_window = broadcast(static_cast<int>((height - 1) * src_stride + width - static_cast<int>(sizeof(int) / sizeof(Sample))));
+	auto sample_mask = broadcast(static_cast<int>((1ll << 8 * sizeof(Sample)) - 1));
+	auto sample_shift = sizeof(Sample) == 1 ? 3 : 4;
+	auto fetch = [&](auto index) {
+		if constexpr (std::is_integral_v<Sample>) {
+			auto start = min(index, last_window);
+			return to_float((gather(srcp, start) >> ((index - start) << sample_shift)) & sample_mask);
+		}
+		else
+			return gather(srcp, index);
+	};
+	auto [lowest, highest] = std::array{ broadcast(0.f), broadcast(static_cast<float>(peak)) };
+	for_each_group(static_cast<int>(first_x), static_cast<int>(last_x), [&](auto x, auto...tail) {
+		auto h = (cosited(gradient_h, x, 0, gradient_last, ssw, tail...) * vector_depth >> 1) >> ssw;
+		auto v = (cosited(gradient_v, x, 0, gradient_last, ssw, tail...) * vector_depth >> 1) >> ssh;
+		v = min(max(v, v_min), v_max);
+		auto remainder_h = (h << 2) & mask127, remainder_v = (v << 2) & mask127;
+		h = (h >> 5) + ((iota() + broadcast(static_cast<int>(x))) << 2);
+		v = upscaled_row + (v >> 5);
+		remainder_h = select((x_limit > h) & (h > minus_one), remainder_h, zero);
+		h = max(min(h, x_limit), zero);
+		auto [columns, column_weights] = fold_axis(h, min(h + one, x_limit), to_float(remainder_h) * fraction, taps);
+		auto [rows, row_weights] = fold_axis(v, v + one, to_float(remainder_v) * fraction, taps);
+		auto value = broadcast(0.f);
+		for (auto i : Range{ taps + 1 }) {
+			auto offset = min(max(rows + broadcast(static_cast<int>(i)), zero), last_row) * stride;
+			auto sum = broadcast(0.f);
+			for (auto k : Range{ taps + 1 })
+				sum = fmadd(column_weights[k], fetch(offset + min(max(columns + broadcast(static_cast<int>(k)), zero), last_column)), sum);
+			value = fmadd(row_weights[i], sum, value);
+		}
+		if constexpr (std::is_integral_v<Sample>)
+			value = min(max(value, lowest), highest);
+		store(dstp + x, value, tail...);
+	});
+};
\ No newline at end of file